@@ -0,0 +1,337 @@
+/**
+* Dynamic and Iterative Spanning Forest (Benchmark)
+*
+* @date October, 2026
+*/
+
+//=============================================================================
+// Includes
+//=============================================================================
+#include "Image.h"
+#include "DISF.h"
+#include "Utils.h"
+
+#include <omp.h>
+#include <stdio.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+//=============================================================================
+// Prototypes
+//=============================================================================
+void usage();
+Image *loadImage(const char* filepath);
+
+int compareDoubles(const void *a, const void *b);
+double benchDISF(Graph *graph, int n_0, int n_f, int num_reps, DISFOptions *opts, Image **label_img);
+double computeLabelAgreement(Image *label_img_1, Image *label_img_2);
+bool countIterations(int num_iters, int num_trees, double elapsed, void *user_data);
+bool isBorderPixel(Image *label_img, int x, int y); // 4-neighborhood
+double computeBorderAgreement(Image *ref_labels, Image *label_img, int radius);
+double computeBorderGradient(Image *label_img, double *grad);
+void benchSchedules(Graph *graph, int n_0, int n_f, int num_reps);
+
+//=============================================================================
+// Main
+//=============================================================================
+int main(int argc, char* argv[])
+{
+    int n_0, n_f, num_reps;
+    double ref_time;
+    Image *img, *ref_labels;
+    Graph *graph;
+    DISFOptions *opts;
+
+    if(argc > 6) usage();
+
+    img = loadImage(argc > 1 ? argv[1] : "man.png");
+    n_0 = argc > 2 ? atoi(argv[2]) : 8000;
+    n_f = argc > 3 ? atoi(argv[3]) : 50;
+    num_reps = argc > 4 ? atoi(argv[4]) : 5;
+
+    opts = createDISFOptions();
+    if(argc > 5) opts->bucket_step = atof(argv[5]);
+
+    if(n_0 <= 1) printError("main", "N0 must be > 1");
+    else if(n_f <= 1) printError("main", "Nf must be > 1");
+    else if(n_0 < n_f) printError("main", "N0 must be >> Nf");
+    else if(num_reps < 1) printError("main", "The number of repetitions must be >= 1");
+    else if(opts->bucket_step <= 0) printError("main", "The bucket step must be > 0");
+
+    graph = createGraph(img);
+    freeImage(&img);
+
+    // The default configuration (heap, full IFT) is the reference
+    ref_time = benchDISF(graph, n_0, n_f, num_reps, opts, &ref_labels);
+
+    printf("engine,bucket_step,differential,median_s,speedup,label_agreement\n");
+    printf("heap,-,no,%.6f,1.00,1.0000\n", ref_time);
+
+    for(int differential = 0; differential <= 1; differential++)
+        for(int engine = HEAP_QUEUE; engine <= BUCKET_QUEUE; engine++)
+        {
+            double time;
+            Image *labels;
+
+            if(engine == HEAP_QUEUE && !differential) continue; // Reference
+
+            opts->queue_engine = (QueueEngine)engine;
+            opts->differential = differential;
+
+            time = benchDISF(graph, n_0, n_f, num_reps, opts, &labels);
+
+            if(engine == BUCKET_QUEUE) printf("bucket,%g,", opts->bucket_step);
+            else printf("heap,-,");
+
+            printf("%s,%.6f,%.2f,%.4f\n", differential ? "yes" : "no", time, ref_time / time, 
+                   computeLabelAgreement(ref_labels, labels));
+
+            freeImage(&labels);
+        }
+
+    printf("\n");
+    benchSchedules(graph, n_0, n_f, num_reps);
+
+    freeDISFOptions(&opts);
+    freeImage(&ref_labels);
+    freeGraph(&graph);
+}
+
+//=============================================================================
+// Methods
+//=============================================================================
+void usage()
+{
+    printf("Usage: DISF_bench <1> <2> <3> <4> <5>\n");
+    printf("----------------------------------\n");
+    printf("INPUTS (optional):\n");
+    printf("<1> - Image (STB's supported formats). Default: man.png\n" );
+    printf("<2> - Initial number of seeds. Default: N0 = 8000\n");
+    printf("<3> - Final number of superpixels. Default: Nf = 50\n");
+    printf("<4> - Number of repetitions per configuration. Default: 5\n");
+    printf("<5> - Bucket queue quantization step. Default: %g\n", DEFAULT_BUCKET_STEP);
+    printError("main", "Too many parameters");
+}
+
+Image *loadImage(const char* filepath)
+{
+    int num_channels, num_rows, num_cols;
+    unsigned char *data;    
+    Image *new_img;
+    
+    data = stbi_load(filepath, &num_cols, &num_rows, &num_channels, 0);
+
+    if(data == NULL)
+        printError("loadImage", "Could not load the image <%s>", filepath);
+
+    new_img = createImageOfType(num_rows, num_cols, num_channels, UINT8_TYPE);
+
+    memcpy(new_img->val.u8, data, (size_t)new_img->num_pixels * num_channels);
+
+    stbi_image_free(data);
+
+    return new_img;
+}
+
+int compareDoubles(const void *a, const void *b)
+{
+    double diff;
+
+    diff = *(const double*)a - *(const double*)b;
+
+    return (diff > 0) - (diff < 0);
+}
+
+double benchDISF(Graph *graph, int n_0, int n_f, int num_reps, DISFOptions *opts, Image **label_img)
+{
+    double median;
+    double *times;
+
+    times = (double*)calloc(num_reps, sizeof(double));
+    *label_img = NULL;
+
+    for(int i = 0; i < num_reps; i++)
+    {
+        double start;
+
+        freeImage(label_img);
+
+        start = omp_get_wtime();
+        *label_img = runDISFWithOptions(graph, n_0, n_f, NULL, opts);
+        times[i] = omp_get_wtime() - start;
+    }
+
+    qsort(times, num_reps, sizeof(double), compareDoubles);
+    median = times[num_reps / 2];
+
+    free(times);
+
+    return median;
+}
+
+// Fraction of pixel pairs (each pixel and its right/bottom neighbor) on which 
+// both label maps agree about being in the same superpixel or not
+double computeLabelAgreement(Image *label_img_1, Image *label_img_2)
+{
+    long num_agree, num_pairs;
+
+    num_agree = num_pairs = 0;
+
+    for(int y = 0; y < label_img_1->num_rows; y++)
+        for(int x = 0; x < label_img_1->num_cols; x++)
+        {
+            int index;
+
+            index = y * label_img_1->num_cols + x;
+
+            if(x + 1 < label_img_1->num_cols)
+            {
+                num_agree += (label_img_1->val.i32[index] == label_img_1->val.i32[index + 1]) ==
+                             (label_img_2->val.i32[index] == label_img_2->val.i32[index + 1]);
+                num_pairs++;
+            }
+
+            if(y + 1 < label_img_1->num_rows)
+            {
+                int below;
+
+                below = index + label_img_1->num_cols;
+
+                num_agree += (label_img_1->val.i32[index] == label_img_1->val.i32[below]) ==
+                             (label_img_2->val.i32[index] == label_img_2->val.i32[below]);
+                num_pairs++;
+            }
+        }
+
+    return num_agree / (double)num_pairs;
+}
+
+bool countIterations(int num_iters, int num_trees, double elapsed, void *user_data)
+{
+    (*(int*)user_data)++;
+
+    return true;
+}
+
+bool isBorderPixel(Image *label_img, int x, int y)
+{
+    bool is_border;
+    int label;
+
+    label = label_img->val.i32[y * label_img->num_cols + x];
+
+    is_border = (x > 0 && label_img->val.i32[y * label_img->num_cols + x - 1] != label) ||
+                (x + 1 < label_img->num_cols && label_img->val.i32[y * label_img->num_cols + x + 1] != label) ||
+                (y > 0 && label_img->val.i32[(y - 1) * label_img->num_cols + x] != label) ||
+                (y + 1 < label_img->num_rows && label_img->val.i32[(y + 1) * label_img->num_cols + x] != label);
+
+    return is_border;
+}
+
+// Agreement of label_img's borders with another segmentation's (e.g., the default schedule's),
+// i.e., the fraction of ref_labels' border pixels with a border pixel of label_img within the
+// given (Chebyshev) radius. Not a boundary recall, as ref_labels is not a ground truth
+double computeBorderAgreement(Image *ref_labels, Image *label_img, int radius)
+{
+    long num_hits, num_borders;
+
+    num_hits = num_borders = 0;
+
+    #pragma omp parallel for reduction(+:num_hits,num_borders)
+    for(int y = 0; y < ref_labels->num_rows; y++)
+        for(int x = 0; x < ref_labels->num_cols; x++)
+        {
+            bool is_hit;
+
+            if(!isBorderPixel(ref_labels, x, y)) continue;
+
+            is_hit = false;
+            for(int dy = -radius; dy <= radius && !is_hit; dy++)
+                for(int dx = -radius; dx <= radius && !is_hit; dx++)
+                    is_hit = y + dy >= 0 && y + dy < label_img->num_rows && x + dx >= 0 && 
+                             x + dx < label_img->num_cols && isBorderPixel(label_img, x + dx, y + dy);
+
+            num_hits += is_hit;
+            num_borders++;
+        }
+
+    return num_borders > 0 ? num_hits / (double)num_borders : 1;
+}
+
+// Mean image gradient over the border pixels, i.e., the higher, the more borders follow edges
+double computeBorderGradient(Image *label_img, double *grad)
+{
+    long num_borders;
+    double sum_grad;
+
+    num_borders = 0;
+    sum_grad = 0;
+
+    #pragma omp parallel for reduction(+:num_borders,sum_grad)
+    for(int y = 0; y < label_img->num_rows; y++)
+        for(int x = 0; x < label_img->num_cols; x++)
+            if(isBorderPixel(label_img, x, y))
+            {
+                sum_grad += grad[y * label_img->num_cols + x];
+                num_borders++;
+            }
+
+    return num_borders > 0 ? sum_grad / num_borders : 0;
+}
+
+// Time vs. boundary quality of each removal schedule. Without a ground truth, the borders are
+// compared to the default schedule's (i.e., agreement, rather than boundary recall)
+void benchSchedules(Graph *graph, int n_0, int n_f, int num_reps)
+{
+    const int num_configs = 7;
+    const RemovalSchedule schedules[] = {EXPONENTIAL_SCHEDULE, EXPONENTIAL_SCHEDULE, EXPONENTIAL_SCHEDULE, 
+                                         GEOMETRIC_SCHEDULE, GEOMETRIC_SCHEDULE, LINEAR_SCHEDULE, 
+                                         LINEAR_SCHEDULE};
+    const char *names[] = {"exponential", "exponential", "exponential", "geometric", "geometric", 
+                           "linear", "linear"};
+    const double params[] = {1, 1.5, 2, 3, 5, 3, 5}; // Rate, or number of stages
+    double ref_time;
+    double *grad;
+    Image *ref_labels;
+    DISFOptions *opts;
+
+    opts = createDISFOptions();
+    opts->progress = countIterations;
+    grad = computeGradient(graph);
+    ref_labels = NULL;
+    ref_time = 0;
+
+    printf("schedule,param,iterations,median_s,speedup,default_border_agreement,border_gradient\n");
+
+    for(int i = 0; i < num_configs; i++)
+    {
+        int num_iters;
+        double time;
+        Image *labels;
+
+        opts->schedule = schedules[i];
+        opts->schedule_rate = params[i];
+        opts->num_stages = (int)params[i];
+
+        num_iters = 0;
+        opts->progress_data = &num_iters;
+
+        time = benchDISF(graph, n_0, n_f, num_reps, opts, &labels);
+
+        if(i == 0) // Reference
+        {
+            ref_time = time;
+            ref_labels = labels;
+        }
+
+        printf("%s,%g,%d,%.6f,%.2f,%.4f,%.4f\n", names[i], params[i], num_iters / num_reps, time, 
+               ref_time / time, computeBorderAgreement(ref_labels, labels, 2), computeBorderGradient(labels, grad));
+
+        if(i > 0) freeImage(&labels);
+    }
+
+    freeImage(&ref_labels);
+    free(grad);
+    freeDISFOptions(&opts);
+}
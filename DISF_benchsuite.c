@@ -0,0 +1,429 @@
+/**
+* Dynamic and Iterative Spanning Forest (Benchmark Suite)
+*
+* @date October, 2026
+* @note Synthetic images are generated at each size, thus no input is needed,
+*       and the results are comparable among machines and revisions
+*/
+
+//=============================================================================
+// Includes
+//=============================================================================
+#include "Image.h"
+#include "DISF.h"
+#include "PrioQueue.h"
+#include "Utils.h"
+
+#include <omp.h>
+#include <stdio.h>
+
+//=============================================================================
+// Constants
+//=============================================================================
+#define MAX_SWEEP_VALUES 16
+#define NUM_PATTERNS 3
+#define NUM_QUEUE_ELEMS 1000000 // Of the PrioQueue micro-benchmarks
+
+//=============================================================================
+// Structures
+//=============================================================================
+typedef enum
+{
+    NOISE_PATTERN, // Uniform i.i.d. values
+    GRADIENT_PATTERN, // Smooth ramps, i.e., no edges
+    TEXTURE_PATTERN // Natural-like: smooth regions, with edges and textures of many scales
+} ImagePattern;
+
+// Lists given by comma-separated values
+typedef struct
+{
+    int num_vals;
+    double vals[MAX_SWEEP_VALUES];
+} SweepValues;
+
+typedef struct
+{
+    SweepValues sizes; // In megapixels
+    SweepValues n_0, n_f, threads;
+    int num_reps;
+    bool as_json;
+    FILE *out_fp;
+    bool has_results; // For the JSON separators
+} SuiteConfig;
+
+//=============================================================================
+// Prototypes
+//=============================================================================
+void usage();
+void parseSweepValues(const char *arg, SweepValues *sweep);
+Image *createSyntheticImage(ImagePattern pattern, int num_rows, int num_cols);
+float getValueNoise(unsigned int seed, float x, float y); // Smoothly interpolated lattice noise, in [0,1]
+unsigned int hashCoords(unsigned int seed, int x, int y);
+
+int compareDoubles(const void *a, const void *b);
+// Writes a result, whose times (in seconds) are sorted. num_elems is of the queue benchmarks (0 otherwise)
+void writeResult(SuiteConfig *config, const char *name, const char *pattern, double megapixels, int num_rows,
+                 int num_cols, int num_threads, int n_0, int n_f, int num_elems, double *times);
+
+void benchImage(SuiteConfig *config, ImagePattern pattern, double megapixels);
+void benchPrioQueue(SuiteConfig *config);
+
+//=============================================================================
+// Main
+//=============================================================================
+int main(int argc, char* argv[])
+{
+    SuiteConfig config;
+
+    parseSweepValues("0.3,2,8,24,100", &(config.sizes));
+    parseSweepValues("8000", &(config.n_0));
+    parseSweepValues("50", &(config.n_f));
+    config.threads.num_vals = 2;
+    config.threads.vals[0] = 1;
+    config.threads.vals[1] = omp_get_max_threads();
+    config.num_reps = 5;
+    config.as_json = false;
+    config.out_fp = stdout;
+    config.has_results = false;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--json") == 0) config.as_json = true;
+        else if(i + 1 >= argc) usage();
+        else if(strcmp(argv[i], "--sizes") == 0) parseSweepValues(argv[++i], &(config.sizes));
+        else if(strcmp(argv[i], "--n0") == 0) parseSweepValues(argv[++i], &(config.n_0));
+        else if(strcmp(argv[i], "--nf") == 0) parseSweepValues(argv[++i], &(config.n_f));
+        else if(strcmp(argv[i], "--threads") == 0) parseSweepValues(argv[++i], &(config.threads));
+        else if(strcmp(argv[i], "--reps") == 0) config.num_reps = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--out") == 0)
+        {
+            config.out_fp = fopen(argv[++i], "w");
+
+            if(config.out_fp == NULL)
+                printError("main", "Could not open the file <%s>", argv[i]);
+        }
+        else usage();
+    }
+
+    if(config.num_reps < 1) printError("main", "The number of repetitions must be >= 1");
+
+    for(int i = 0; i < config.threads.num_vals; i++)
+        if(config.threads.vals[i] < 1 || config.threads.vals[i] != (int)config.threads.vals[i])
+            printError("main", "The numbers of threads must be integers >= 1");
+
+    if(config.as_json) fprintf(config.out_fp, "[\n");
+    else fprintf(config.out_fp, "benchmark,pattern,megapixels,rows,cols,threads,n_0,n_f,elems,reps,median_s,p95_s\n");
+
+    benchPrioQueue(&config);
+
+    for(int i = 0; i < config.sizes.num_vals; i++)
+        for(int pattern = NOISE_PATTERN; pattern < NUM_PATTERNS; pattern++)
+            benchImage(&config, (ImagePattern)pattern, config.sizes.vals[i]);
+
+    if(config.as_json) fprintf(config.out_fp, "\n]\n");
+
+    if(config.out_fp != stdout) fclose(config.out_fp);
+}
+
+//=============================================================================
+// Methods
+//=============================================================================
+void usage()
+{
+    printf("Usage: DISF_benchsuite [options]\n");
+    printf("----------------------------------\n");
+    printf("OPTIONS (lists are comma-separated):\n");
+    printf("--sizes <list> - Image sizes, in megapixels. Default: 0.3,2,8,24,100\n");
+    printf("--n0 <list> - Initial numbers of seeds. Default: 8000\n");
+    printf("--nf <list> - Final numbers of superpixels. Default: 50\n");
+    printf("--threads <list> - Numbers of threads. Default: 1 and the maximum\n");
+    printf("--reps <num> - Repetitions per measurement. Default: 5\n");
+    printf("--json - Writes JSON, instead of CSV\n");
+    printf("--out <file> - Output file. Default: stdout\n");
+    printError("main", "Invalid parameters");
+}
+
+void parseSweepValues(const char *arg, SweepValues *sweep)
+{
+    char *end;
+
+    sweep->num_vals = 0;
+
+    do
+    {
+        if(sweep->num_vals == MAX_SWEEP_VALUES)
+            printError("parseSweepValues", "At most %d values are supported", MAX_SWEEP_VALUES);
+
+        sweep->vals[sweep->num_vals] = strtod(arg, &end);
+
+        if(end == arg || sweep->vals[sweep->num_vals] <= 0)
+            printError("parseSweepValues", "Invalid list <%s>", arg);
+
+        sweep->num_vals++;
+        arg = end + 1;
+    } while(*end == ',');
+
+    if(*end != '\0') printError("parseSweepValues", "Invalid list");
+}
+
+Image *createSyntheticImage(ImagePattern pattern, int num_rows, int num_cols)
+{
+    Image *img;
+
+    img = createImageOfType(num_rows, num_cols, 3, UINT8_TYPE);
+
+    #pragma omp parallel for
+    for(int y = 0; y < num_rows; y++)
+        for(int x = 0; x < num_cols; x++)
+        {
+            int index;
+
+            index = (y * num_cols + x) * 3;
+
+            for(int c = 0; c < 3; c++)
+            {
+                float val;
+
+                if(pattern == NOISE_PATTERN)
+                    val = (hashCoords(c, x, y) & 0xFF) / 255.0;
+                else if(pattern == GRADIENT_PATTERN)
+                    val = (x / (float)num_cols + (c == 1 ? y / (float)num_rows : 0) + c * 0.25) / 2.25;
+                else
+                {
+                    float regions, texture;
+
+                    // Flat regions (quantized coarse noise) with fine-grained texture
+                    regions = floorf(getValueNoise(c, x / 128.0, y / 128.0) * 6) / 5;
+                    texture = 0.5 * getValueNoise(c + 3, x / 16.0, y / 16.0) +
+                              0.5 * getValueNoise(c + 6, x / 3.0, y / 3.0);
+
+                    val = 0.85 * regions + 0.15 * texture;
+                }
+
+                img->val.u8[index + c] = (unsigned char)(255 * fminf(fmaxf(val, 0), 1));
+            }
+        }
+
+    return img;
+}
+
+unsigned int hashCoords(unsigned int seed, int x, int y)
+{
+    unsigned int hash;
+
+    // Integer mixing, as in MurmurHash3's finalizer
+    hash = seed * 0x9E3779B9u ^ (unsigned int)x * 0x85EBCA6Bu ^ (unsigned int)y * 0xC2B2AE35u;
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6Bu;
+    hash ^= hash >> 13;
+    hash *= 0xC2B2AE35u;
+    hash ^= hash >> 16;
+
+    return hash;
+}
+
+float getValueNoise(unsigned int seed, float x, float y)
+{
+    int x0, y0;
+    float fx, fy, top, bottom;
+
+    x0 = (int)floorf(x);
+    y0 = (int)floorf(y);
+
+    // Smoothstep weights
+    fx = x - x0; fx = fx * fx * (3 - 2 * fx);
+    fy = y - y0; fy = fy * fy * (3 - 2 * fy);
+
+    top = (hashCoords(seed, x0, y0) & 0xFFFF) * (1 - fx) + (hashCoords(seed, x0 + 1, y0) & 0xFFFF) * fx;
+    bottom = (hashCoords(seed, x0, y0 + 1) & 0xFFFF) * (1 - fx) + (hashCoords(seed, x0 + 1, y0 + 1) & 0xFFFF) * fx;
+
+    return (top * (1 - fy) + bottom * fy) / 65535.0;
+}
+
+int compareDoubles(const void *a, const void *b)
+{
+    double diff;
+
+    diff = *(const double*)a - *(const double*)b;
+
+    return (diff > 0) - (diff < 0);
+}
+
+void writeResult(SuiteConfig *config, const char *name, const char *pattern, double megapixels, int num_rows,
+                 int num_cols, int num_threads, int n_0, int n_f, int num_elems, double *times)
+{
+    double median, p95;
+
+    qsort(times, config->num_reps, sizeof(double), compareDoubles);
+
+    median = times[config->num_reps / 2];
+    p95 = times[MAX((int)ceil(0.95 * config->num_reps) - 1, 0)];
+
+    if(config->as_json)
+    {
+        fprintf(config->out_fp, "%s  {\"benchmark\": \"%s\", \"pattern\": \"%s\", \"megapixels\": %g, \"rows\": %d, "
+                "\"cols\": %d, \"threads\": %d, \"n_0\": %d, \"n_f\": %d, \"elems\": %d, \"reps\": %d, "
+                "\"median_s\": %.9f, \"p95_s\": %.9f}", config->has_results ? ",\n" : "", name, pattern, megapixels, 
+                num_rows, num_cols, num_threads, n_0, n_f, num_elems, config->num_reps, median, p95);
+    }
+    else
+        fprintf(config->out_fp, "%s,%s,%g,%d,%d,%d,%d,%d,%d,%d,%.9f,%.9f\n", name, pattern, megapixels, num_rows,
+                num_cols, num_threads, n_0, n_f, num_elems, config->num_reps, median, p95);
+
+    fflush(config->out_fp);
+    config->has_results = true;
+}
+
+// createGraph, computeGradient, gridSampling and runDISF, for each number of threads (and
+// numbers of seeds)
+void benchImage(SuiteConfig *config, ImagePattern pattern, double megapixels)
+{
+    const char *pattern_names[] = {"noise", "gradient", "texture"};
+    int num_rows, num_cols;
+    double *times;
+    Image *img;
+    Graph *graph;
+
+    // 4:3 aspect ratio
+    num_rows = MAX((int)round(sqrt(megapixels * 1e6 * 3 / 4)), 1);
+    num_cols = MAX((int)round(megapixels * 1e6 / num_rows), 1);
+
+    img = createSyntheticImage(pattern, num_rows, num_cols);
+    times = (double*)calloc(config->num_reps, sizeof(double));
+    graph = NULL;
+
+    for(int t = 0; t < config->threads.num_vals; t++)
+    {
+        int num_threads;
+
+        num_threads = (int)config->threads.vals[t];
+        omp_set_num_threads(num_threads);
+
+        for(int i = 0; i < config->num_reps; i++)
+        {
+            double start;
+
+            freeGraph(&graph);
+
+            start = omp_get_wtime();
+            graph = createGraph(img);
+            times[i] = omp_get_wtime() - start;
+        }
+        writeResult(config, "createGraph", pattern_names[pattern], megapixels, num_rows, num_cols, num_threads,
+                    0, 0, 0, times);
+
+        for(int i = 0; i < config->num_reps; i++)
+        {
+            double start;
+            double *grad;
+
+            start = omp_get_wtime();
+            grad = computeGradient(graph);
+            times[i] = omp_get_wtime() - start;
+
+            free(grad);
+        }
+        writeResult(config, "computeGradient", pattern_names[pattern], megapixels, num_rows, num_cols,
+                    num_threads, 0, 0, 0, times);
+
+        for(int j = 0; j < config->n_0.num_vals; j++)
+        {
+            int n_0;
+
+            n_0 = (int)config->n_0.vals[j];
+
+            for(int i = 0; i < config->num_reps; i++)
+            {
+                double start;
+                IntList *seeds;
+
+                start = omp_get_wtime();
+                seeds = gridSampling(graph, n_0);
+                times[i] = omp_get_wtime() - start;
+
+                freeIntList(&seeds);
+            }
+            writeResult(config, "gridSampling", pattern_names[pattern], megapixels, num_rows, num_cols,
+                        num_threads, n_0, 0, 0, times);
+
+            for(int k = 0; k < config->n_f.num_vals; k++)
+            {
+                int n_f;
+
+                n_f = (int)config->n_f.vals[k];
+
+                if(n_f > n_0) continue;
+
+                for(int i = 0; i < config->num_reps; i++)
+                {
+                    double start;
+                    Image *label_img;
+
+                    start = omp_get_wtime();
+                    label_img = runDISF(graph, n_0, n_f, NULL);
+                    times[i] = omp_get_wtime() - start;
+
+                    freeImage(&label_img);
+                }
+                writeResult(config, "runDISF", pattern_names[pattern], megapixels, num_rows, num_cols,
+                            num_threads, n_0, n_f, 0, times);
+            }
+        }
+    }
+
+    freeGraph(&graph);
+    freeImage(&img);
+    free(times);
+}
+
+// Insertions, pops and decrease-keys of NUM_QUEUE_ELEMS random priorities. Times are per operation
+void benchPrioQueue(SuiteConfig *config)
+{
+    double *prio, *insert_times, *pop_times, *decrease_times;
+    PrioQueue *queue;
+
+    prio = (double*)calloc(NUM_QUEUE_ELEMS, sizeof(double));
+    insert_times = (double*)calloc(config->num_reps, sizeof(double));
+    pop_times = (double*)calloc(config->num_reps, sizeof(double));
+    decrease_times = (double*)calloc(config->num_reps, sizeof(double));
+    queue = createPrioQueue(NUM_QUEUE_ELEMS, prio, MINVAL_POLICY);
+
+    for(int i = 0; i < config->num_reps; i++)
+    {
+        double start;
+
+        for(int j = 0; j < NUM_QUEUE_ELEMS; j++)
+            prio[j] = hashCoords(i, j, 0) / 4294967296.0;
+
+        start = omp_get_wtime();
+        for(int j = 0; j < NUM_QUEUE_ELEMS; j++)
+            insertPrioQueue(&queue, j);
+        insert_times[i] = (omp_get_wtime() - start) / NUM_QUEUE_ELEMS;
+
+        // Every element halves its priority
+        start = omp_get_wtime();
+        for(int j = 0; j < NUM_QUEUE_ELEMS; j++)
+        {
+            prio[j] /= 2;
+            moveIndexUpPrioQueue(&queue, j);
+        }
+        decrease_times[i] = (omp_get_wtime() - start) / NUM_QUEUE_ELEMS;
+
+        start = omp_get_wtime();
+        while(!isPrioQueueEmpty(queue))
+            popPrioQueue(&queue);
+        pop_times[i] = (omp_get_wtime() - start) / NUM_QUEUE_ELEMS;
+
+        resetPrioQueue(&queue);
+    }
+
+    writeResult(config, "PrioQueue.insert", "random", 0, 0, 0, 1, 0, 0, NUM_QUEUE_ELEMS, insert_times);
+    writeResult(config, "PrioQueue.decrease", "random", 0, 0, 0, 1, 0, 0, NUM_QUEUE_ELEMS, decrease_times);
+    writeResult(config, "PrioQueue.pop", "random", 0, 0, 0, 1, 0, 0, NUM_QUEUE_ELEMS, pop_times);
+
+    freePrioQueue(&queue);
+    free(prio);
+    free(insert_times);
+    free(pop_times);
+    free(decrease_times);
+}
@@ -13,6 +13,7 @@
 
 #include <time.h>
 #include <stdio.h>
+#include <omp.h>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -23,36 +24,57 @@
 void usage();
 Image *loadImage(const char* filepath);
 void writeImagePGM(Image *img, char* filepath);
+void printStats(DISFStats *stats);
 
 //=============================================================================
 // Main
 //=============================================================================
 int main(int argc, char* argv[])
 {
-    int n_0, n_f;
+    int n_0, n_f, num_args;
+    double start;
     Image *img, *border_img, *label_img;
     Graph *graph;
+    DISFOptions *opts;
 
-    // if(argc != 4) usage();
-    // img = loadImage(argv[1]);
-    // n_0 = atoi(argv[2]);
-    // n_f = atoi(argv[3]);
+    opts = createDISFOptions();
 
-    // if(n_0 <= 1) printError("main", "N0 must be > 1");
-    // else if(n_f <= 1) printError("main", "Nf must be > 1");
-    // else if(n_0 < n_f) printError("main", "N0 must be >> Nf");
-    
-    img = loadImage("man.png");
-    n_0 = 8000;
-    n_f = 50;
+    // The flag may be anywhere, and the remaining arguments are positional
+    num_args = 0;
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--stats") == 0) opts->stats = createDISFStats();
+        else argv[++num_args] = argv[i];
+    }
+
+    if(num_args != 0 && num_args != 3) usage();
+
+    img = loadImage(num_args > 0 ? argv[1] : "man.png");
+    n_0 = num_args > 0 ? atoi(argv[2]) : 8000;
+    n_f = num_args > 0 ? atoi(argv[3]) : 50;
+
+    if(n_0 <= 1) printError("main", "N0 must be > 1");
+    else if(n_f <= 1) printError("main", "Nf must be > 1");
+    else if(n_0 < n_f) printError("main", "N0 must be >> Nf");
+
+    border_img = createImageOfType(img->num_rows, img->num_cols, 1, UINT8_TYPE);
 
-    border_img = createImage(img->num_rows, img->num_cols, 1);
+    start = omp_get_wtime();
     graph = createGraph(img);
+    if(opts->stats != NULL) opts->stats->graph_time = omp_get_wtime() - start;
+
     freeImage(&img);
 
-    label_img = runDISF(graph, n_0, n_f, &border_img);
+    label_img = runDISFWithOptions(graph, n_0, n_f, &border_img, opts);
     freeGraph(&graph);
 
+    if(opts->stats != NULL)
+    {
+        printStats(opts->stats);
+        freeDISFStats(&(opts->stats));
+    }
+    freeDISFOptions(&opts);
+
     writeImagePGM(label_img, "labels.pgm");
     writeImagePGM(border_img, "borders.pgm");
 
@@ -65,12 +87,13 @@ int main(int argc, char* argv[])
 //=============================================================================
 void usage()
 {
-    printf("Usage: DISF_demo <1> <2> <3>\n");
+    printf("Usage: DISF_demo [<1> <2> <3>] [--stats]\n");
     printf("----------------------------------\n");
-    printf("INPUTS:\n");
-    printf("<1> - Image (STB's supported formats)\n" );
-    printf("<2> - Initial number of seeds (e.g., N0 = 8000)\n");
-    printf("<3> - Final number of superpixels (e.g., Nf = 50)\n");
+    printf("INPUTS (optional):\n");
+    printf("<1> - Image (STB's supported formats). Default: man.png\n" );
+    printf("<2> - Initial number of seeds. Default: N0 = 8000\n");
+    printf("<3> - Final number of superpixels. Default: Nf = 50\n");
+    printf("--stats - Prints the timings and counters of each phase\n");
     printError("main", "Too many/few parameters");
 }
 
@@ -85,18 +108,9 @@ Image *loadImage(const char* filepath)
     if(data == NULL)
         printError("loadImage", "Could not load the image <%s>", filepath);
 
-    new_img = createImage(num_rows, num_cols, num_channels);
+    new_img = createImageOfType(num_rows, num_cols, num_channels, UINT8_TYPE);
 
-    #pragma omp parallel for
-    for(int i = 0; i < new_img->num_pixels; i++)
-    {
-        new_img->val[i] = (int*)calloc(new_img->num_channels, sizeof(int));
-
-        for(int j = 0; j < new_img->num_channels; j++)
-        {
-            new_img->val[i][j] = data[i * new_img->num_channels + j];
-        }
-    }
+    memcpy(new_img->val.u8, data, (size_t)new_img->num_pixels * num_channels);
 
     stbi_image_free(data);
 
@@ -128,7 +142,7 @@ void writeImagePGM(Image *img, char* filepath)
         data = (unsigned char*)calloc(img->num_pixels, sizeof(unsigned char));
 
         for(int i = 0; i < img->num_pixels; i++)
-            data[i] = (unsigned char)img->val[i][0];
+            data[i] = (unsigned char)getImageVal(img, i, 0);
 
         fwrite(data, sizeof(unsigned char), img->num_pixels, fp);
 
@@ -142,7 +156,7 @@ void writeImagePGM(Image *img, char* filepath)
         data = (unsigned short*)calloc(img->num_pixels, sizeof(unsigned short));
 
         for(int i = 0; i < img->num_pixels; i++)
-            data[i] = (unsigned short)img->val[i][0];
+            data[i] = (unsigned short)getImageVal(img, i, 0);
         
         for(int i = 0; i < img->num_pixels; i++)
         {
@@ -161,4 +175,29 @@ void writeImagePGM(Image *img, char* filepath)
         printError("writeImagePGM", "Invalid min/max spel values <%d,%d>", min_val, max_val);
 
     fclose(fp);
-}
\ No newline at end of file
+}
+
+void printStats(DISFStats *stats)
+{
+    double ift_time, selection_time;
+
+    ift_time = selection_time = 0;
+
+    printf("iter,trees,ift_ms,selection_ms,pushes,pops,decreases\n");
+
+    for(int i = 0; i < stats->num_iters; i++)
+    {
+        printf("%d,%d,%.3lf,%.3lf,%ld,%ld,%ld\n", i + 1, stats->num_trees[i], stats->ift_time[i] * 1000, 
+               stats->selection_time[i] * 1000, stats->num_pushes[i], stats->num_pops[i], stats->num_decreases[i]);
+
+        ift_time += stats->ift_time[i];
+        selection_time += stats->selection_time[i];
+    }
+
+    printf("graph: %.3lf ms\n", stats->graph_time * 1000);
+    printf("sampling: %.3lf ms\n", stats->sampling_time * 1000);
+    printf("ift: %.3lf ms\n", ift_time * 1000);
+    printf("selection: %.3lf ms\n", selection_time * 1000);
+    printf("total (without graph): %.3lf ms\n", stats->total_time * 1000);
+    printf("peak: %.1lf MiB\n", stats->peak_bytes / (1024.0 * 1024.0));
+}
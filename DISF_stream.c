@@ -0,0 +1,187 @@
+/**
+* Dynamic and Iterative Spanning Forest (Streaming)
+*
+* @date October, 2026
+*/
+
+//=============================================================================
+// Includes
+//=============================================================================
+#include "Image.h"
+#include "DISF.h"
+#include "DISFStream.h"
+#include "Utils.h"
+
+#include <omp.h>
+#include <stdio.h>
+
+//=============================================================================
+// Structures
+//=============================================================================
+typedef struct
+{
+    FILE *border_fp, *label_fp; // The latter may be NULL
+} StreamFiles;
+
+//=============================================================================
+// Prototypes
+//=============================================================================
+void usage();
+FILE *openPNM(const char *filepath, int *num_rows, int *num_cols, int *num_channels, int *max_val);
+void readPNMRows(FILE *fp, int max_val, Image *rows);
+void writeStreamRows(int first_row, int num_rows, int num_cols, int *labels, unsigned char *borders, void *user_data);
+
+//=============================================================================
+// Main
+//=============================================================================
+int main(int argc, char* argv[])
+{
+    int n_0, n_f, band_rows, num_rows, num_cols, num_channels, max_val, chunk_rows;
+    double start;
+    FILE *img_fp;
+    StreamFiles files;
+    Image *rows;
+    DISFStream *stream;
+
+    if(argc < 5 || argc > 7) usage();
+
+    img_fp = openPNM(argv[1], &num_rows, &num_cols, &num_channels, &max_val);
+    n_0 = atoi(argv[2]);
+    n_f = atoi(argv[3]);
+    band_rows = argc > 6 ? atoi(argv[6]) : 0;
+
+    if(n_0 <= 1) printError("main", "N0 must be > 1");
+    else if(n_f <= 1) printError("main", "Nf must be > 1");
+    else if(n_0 < n_f) printError("main", "N0 must be >> Nf");
+
+    files.border_fp = fopen(argv[4], "wb");
+    if(files.border_fp == NULL)
+        printError("main", "Could not open the file <%s>", argv[4]);
+
+    // The dimensions are known beforehand
+    fprintf(files.border_fp, "P5\n%d %d\n255\n", num_cols, num_rows);
+
+    files.label_fp = NULL;
+    if(argc > 5)
+    {
+        files.label_fp = fopen(argv[5], "wb");
+
+        if(files.label_fp == NULL)
+            printError("main", "Could not open the file <%s>", argv[5]);
+    }
+
+    stream = createDISFStream(num_rows, num_cols, num_channels, n_0, n_f, band_rows, -1, NULL,
+                              writeStreamRows, &files);
+
+    // Rows are read as needed
+    chunk_rows = 16;
+    rows = createImageOfType(chunk_rows, num_cols, num_channels, max_val < 256 ? UINT8_TYPE : UINT16_TYPE);
+
+    start = omp_get_wtime();
+
+    for(int y = 0; y < num_rows; y += chunk_rows)
+    {
+        if(num_rows - y < chunk_rows)
+        {
+            freeImage(&rows);
+            rows = createImageOfType(num_rows - y, num_cols, num_channels, max_val < 256 ? UINT8_TYPE : UINT16_TYPE);
+        }
+
+        readPNMRows(img_fp, max_val, rows);
+        pushDISFStreamRows(stream, rows);
+    }
+
+    finishDISFStream(stream);
+
+    printf("%d superpixels in %.3lf s (bands of %d + %d rows)\n", stream->num_labels,
+           omp_get_wtime() - start, stream->band_rows, stream->overlap_rows);
+
+    freeDISFStream(&stream);
+    freeImage(&rows);
+
+    fclose(img_fp);
+    fclose(files.border_fp);
+    if(files.label_fp != NULL) fclose(files.label_fp);
+}
+
+//=============================================================================
+// Methods
+//=============================================================================
+void usage()
+{
+    printf("Usage: DISF_stream <1> <2> <3> <4> [5] [6]\n");
+    printf("----------------------------------\n");
+    printf("INPUTS:\n");
+    printf("<1> - Binary PGM (P5) or PPM (P6) image, of 8 or 16 bits\n" );
+    printf("<2> - Initial number of seeds (e.g., N0 = 8000)\n");
+    printf("<3> - Final number of superpixels (e.g., Nf = 50)\n");
+    printf("<4> - Output border image (PGM)\n");
+    printf("[5] - Output label image (raw int32, row-major)\n");
+    printf("[6] - Rows per band (default: from the superpixel side)\n");
+    printError("main", "Too many/few parameters");
+}
+
+FILE *openPNM(const char *filepath, int *num_rows, int *num_cols, int *num_channels, int *max_val)
+{
+    char magic[3];
+    FILE *fp;
+
+    fp = fopen(filepath, "rb");
+
+    if(fp == NULL)
+        printError("openPNM", "Could not open the file <%s>", filepath);
+
+    if(fscanf(fp, "%2s", magic) != 1 || magic[0] != 'P' || (magic[1] != '5' && magic[1] != '6'))
+        printError("openPNM", "Only binary PGM and PPM files are supported");
+
+    *num_channels = magic[1] == '5' ? 1 : 3;
+
+    // Header comments are not supported
+    if(fscanf(fp, "%d %d %d", num_cols, num_rows, max_val) != 3 || *max_val < 1 || *max_val > 65535)
+        printError("openPNM", "Invalid header of <%s>", filepath);
+
+    fgetc(fp); // Single whitespace before the data
+
+    return fp;
+}
+
+void readPNMRows(FILE *fp, int max_val, Image *rows)
+{
+    size_t num_vals;
+
+    num_vals = (size_t)rows->num_pixels * rows->num_channels;
+
+    if(max_val < 256)
+    {
+        if(fread(rows->val.u8, sizeof(unsigned char), num_vals, fp) != num_vals)
+            printError("readPNMRows", "Unexpected end of file");
+    }
+    else
+    {
+        // Big-endian 16-bit samples
+        for(size_t i = 0; i < num_vals; i++)
+        {
+            int high, low;
+
+            high = fgetc(fp);
+            low = fgetc(fp);
+
+            if(low == EOF)
+                printError("readPNMRows", "Unexpected end of file");
+
+            rows->val.u16[i] = (unsigned short)((high << 8) | low);
+        }
+    }
+}
+
+void writeStreamRows(int first_row, int num_rows, int num_cols, int *labels, unsigned char *borders, void *user_data)
+{
+    StreamFiles *files;
+
+    files = (StreamFiles*)user_data;
+
+    fwrite(borders, sizeof(unsigned char), (size_t)num_rows * num_cols, files->border_fp);
+
+    if(files->label_fp != NULL)
+        fwrite(labels, sizeof(int), (size_t)num_rows * num_cols, files->label_fp);
+}
@@ -0,0 +1,67 @@
+/**
+* Bucket Queue (Dial)
+*
+* @date October, 2026
+* @note Minimum-priority queue for monotone (e.g., max-arc) path costs. 
+*       Priorities are quantized by a fixed step into buckets, and elements 
+*       within the same bucket are removed in FIFO order. The original 
+*       (non-quantized) priorities are kept untouched in prio.
+*/
+#ifndef BUCKETQUEUE_H
+#define BUCKETQUEUE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//=============================================================================
+// Includes
+//=============================================================================
+#include "Utils.h"
+#include "PrioQueue.h"
+
+//=============================================================================
+// Structures
+//=============================================================================
+typedef struct
+{
+    int size, num_elems, num_buckets, curr_bucket;
+    double step; // Quantization step, i.e., bucket = prio/step
+    int *first, *last; // Head and tail of each bucket
+    int *next, *prev, *bucket; // Doubly-linked FIFO of each element, if GRAY_STATE
+    double *prio; // Priority (clone)
+    unsigned int *stamp, generation; // As in PrioQueue
+    int prio_stride, stamp_stride; // Idem
+    bool owns_stamp;
+} BucketQueue;
+
+//=============================================================================
+// Prototypes
+//=============================================================================
+// Priorities above max_prio are stored at the last bucket
+BucketQueue *createBucketQueue(int size, double *prio, double max_prio, double step);
+// As createPrioQueueOfRecords
+BucketQueue *createBucketQueueOfRecords(int size, double *prio, int prio_stride, unsigned int *stamp, 
+                                        int stamp_stride, double max_prio, double step);
+void freeBucketQueue(BucketQueue **queue);
+
+bool insertBucketQueue(BucketQueue **queue, int index);
+bool isBucketQueueEmpty(BucketQueue *queue);
+
+int getBucketOfPrio(BucketQueue *queue, double prio);
+int popBucketQueue(BucketQueue **queue);
+
+ElemState getBucketQueueState(BucketQueue *queue, int index);
+
+// Must be called whenever the priority of an inserted element changes
+void moveIndexBucketQueue(BucketQueue **queue, int index);
+void removeBucketQueueElem(BucketQueue **queue, int index);
+void resetBucketQueue(BucketQueue **queue); // O(num_buckets), but for a generation overflow
+// Of an element out of the queue (i.e., not GRAY_STATE), within the current generation
+void setBucketQueueState(BucketQueue *queue, int index, ElemState state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BUCKETQUEUE_H
@@ -19,23 +19,54 @@ extern "C" {
 // Includes
 //=============================================================================
 #include "Utils.h"
+#include "Image.h"
 #include <math.h>
 
 //=============================================================================
 // Constants
 //=============================================================================
 static const float D65_WHITE[] = {0.950456, 1.0, 1.088754};
+// Linear sRGB to XYZ, by row
+static const double SRGB_TO_XYZ[3][3] = {
+    {0.4123955889674142161, 0.3575834307637148171, 0.1804926473817015735},
+    {0.2125862307855955516, 0.7151703037034108499, 0.07220049864333622685},
+    {0.01929721549174694484, 0.1191838645808485318, 0.9504971251315797660}
+};
+// Pixels converted at once by convertRowToLab
+#define COLOR_BLOCK_SIZE 256
 
 //=============================================================================
 // Prototypes
 //=============================================================================
 float gammaCorr(float value); // value must be srgb norm in [0,1]
 float labFunc(float value); // value must be xyz norm by D65 white
+float fastCbrt(float value); // value must be >= 0. Within a float's precision
+
+// Linearized (i.e., gammaCorr) values of every 8-bit (normval = 255) or 16-bit 
+// (normval = 65535) intensity, built once. NULL for other normvals
+const float *getsRGBGammaLUT(int normval);
 
 // For 8- and 16-bit, normval is 255 and 65535
 float *convertGrayToLab(int* gray, int normval);
 float *convertsRGBToLab(int* srgb, int normval);
 
+// Allocation-free variants. L*, a* and b* are written at lab[0], lab[stride]
+// and lab[2 * stride] (i.e., stride = 1 for interleaved and N for planar)
+void convertGrayToLabInto(int* gray, int normval, float *lab, int stride);
+void convertsRGBToLabInto(int* srgb, int normval, float *lab, int stride);
+// As convertsRGBToLabInto, with gamma_lut = getsRGBGammaLUT(normval), for avoiding 
+// the gamma correction's pow calls. Values must be within [0,normval]
+void convertGrayToLabFromLUT(int* gray, const float *gamma_lut, float *lab, int stride);
+void convertsRGBToLabFromLUT(int* srgb, const float *gamma_lut, float *lab, int stride);
+// Batch variant, over num_pixels interleaved pixels of the given type (gray or sRGB, w/ w/o 
+// alpha), whose normval is ignored if FLOAT32_TYPE (i.e., values within [0,1]). gamma_lut is
+// getsRGBGammaLUT(normval), fetched once by the caller, or NULL for gammaCorr. The i-th 
+// pixel's L* is written at lab[i * pixel_stride], and its a* and b* as in 
+// convertsRGBToLabInto (i.e., feat_stride). The arithmetic is vectorized with the widest
+// instruction set of the CPU (AVX-512, AVX2 or SSE4.1, if x86), and yields the same values
+void convertRowToLab(void *vals, PixelType type, int num_channels, int num_pixels, int normval, 
+                     const float *gamma_lut, float *lab, int pixel_stride, int feat_stride);
+
 
 #ifdef __cplusplus
 }
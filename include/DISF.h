@@ -18,6 +18,8 @@ extern "C" {
 #include "Color.h"
 #include "IntList.h"
 #include "PrioQueue.h"
+#include "BucketQueue.h"
+#include "RegionAdj.h"
 
 //=============================================================================
 // Macros
@@ -25,9 +27,35 @@ extern "C" {
 #define MIN(X, Y) (((X) < (Y)) ? (X) : (Y))
 #define MAX(X, Y) (((X) > (Y)) ? (X) : (Y))
 
+//=============================================================================
+// Constants
+//=============================================================================
+// Upper bound of the L2 distance between two sRGB colors in CIELAB, i.e., the 
+// diagonal of the gamut's bounding box (L* in [0,100], a* in [-86.2,98.3] and 
+// b* in [-107.9,94.5]), rounded up. Path costs are max-arc, thus bounded by it
+#define MAX_LAB_DIST 300.0
+// Default bucket width (in Lab units). Arc costs closer than it are popped in 
+// FIFO order, which is well below the just-noticeable difference (~2.3)
+#define DEFAULT_BUCKET_STEP 0.01
+// Default distance (in Lab units) between the mean colors of a cell, in two 
+// frames, for it to be considered changed. See runDISFTemporal
+#define DEFAULT_CHANGE_THRESHOLD 2.3
+
 //=============================================================================
 // Structures
 //=============================================================================
+typedef enum
+{
+    INTERLEAVED_LAYOUT, // AoS: feats[i * num_feats + f]
+    PLANAR_LAYOUT // SoA: feats[f * num_nodes + i]
+} FeatLayout;
+
+typedef enum
+{
+    HEAP_QUEUE, // d-ary (i.e., 4-ary) heap (exact order)
+    BUCKET_QUEUE // Dial's bucket queue (order quantized by bucket_step)
+} QueueEngine;
+
 typedef struct
 {
     int x, y;
@@ -43,28 +71,152 @@ typedef struct
 {
     int root_index, num_nodes, num_feats;
     float *sum_feat;
+    float *mean_feat; // Kept up-to-date by insertNodeInTree
 } Tree;
 
+// Filled by a run, if given in its options
+typedef struct
+{
+    // In seconds. The graph is an input of the runs, thus graph_time is left to whoever builds
+    // it. The sampling includes the gradient, which is only evaluated around the grid points
+    double graph_time, sampling_time, total_time;
+    int num_iters, iter_capacity;
+    // Per iteration
+    int *num_trees;
+    double *ift_time, *selection_time;
+    long *num_pushes, *num_pops, *num_decreases; // Of the IFT queue(s). Pops are the pixels visited
+    size_t peak_bytes; // Of the workspace (whose buffers only grow) and the graph
+    // As hasDISFReachedTarget, thus also known after the runs whose workspace is internal (e.g., 
+    // runDISFWithOptions)
+    bool has_reached_target;
+} DISFStats;
+
+// Number of trees kept after each iteration (i.e., num_maintain), which is never below n_f. 
+// The run ends once an iteration removes none, thus it must decrease until reaching n_f
+typedef enum
+{
+    EXPONENTIAL_SCHEDULE, // n_0 * exp(-schedule_rate * iter)
+    GEOMETRIC_SCHEDULE, // n_0 * (n_f / n_0)^(iter / num_stages), i.e., n_f after num_stages
+    LINEAR_SCHEDULE, // n_0 - iter * (n_0 - n_f) / num_stages, idem
+    CUSTOM_SCHEDULE // schedule_func
+} RemovalSchedule;
+
+typedef double (*DISFSchedule)(int iter, int n_0, int n_f, void *user_data); // iter >= 1
+
+// Called after each forest is grown, with the iterations performed so far, the forest's number
+// of trees and the seconds elapsed since the call began. Returning false stops the run
+typedef bool (*DISFProgress)(int num_iters, int num_trees, double elapsed, void *user_data);
+
+typedef struct
+{
+    QueueEngine queue_engine; // Default: HEAP_QUEUE
+    double bucket_step; // Only for BUCKET_QUEUE. Default: DEFAULT_BUCKET_STEP
+    // Differential IFT: only the regions of the removed trees are re-conquered, 
+    // from the kept trees' frontier, instead of regrowing the whole forest. Kept
+    // trees never lose nodes, so the result differs from the default mode. 
+    // Default: false
+    bool differential;
+    // Tile-parallel IFT: if > 1, the image is split into num_tiles horizontal
+    // strips whose forests are grown concurrently (each from the seeds within
+    // it). Then, each seam is repaired by re-conquering the seam_width rows at
+    // both sides of it, plus the trees rooted there, so that trees may cross
+    // it. Decisions away from the seams remain tile-local, thus the result 
+    // approximates the sequential forest. Ignored in differential mode.
+    // Default: 1
+    int num_tiles;
+    int seam_width; // 0 for the approximate superpixel side. Default: 0
+    float change_threshold; // Only for runDISFTemporal. Default: DEFAULT_CHANGE_THRESHOLD
+    RemovalSchedule schedule; // Default: EXPONENTIAL_SCHEDULE
+    double schedule_rate; // Only for EXPONENTIAL_SCHEDULE, and > 0. Default: 1
+    int num_stages; // Only for GEOMETRIC_SCHEDULE and LINEAR_SCHEDULE, and >= 1. Default: 3
+    DISFSchedule schedule_func; // Only for CUSTOM_SCHEDULE. Default: NULL
+    void *schedule_data; // Given to schedule_func. Default: NULL
+    // Anytime mode: the run stops, returning the last forest grown, once the next iteration is
+    // not expected (i.e., as long as the last one) to end within time_budget seconds, or after
+    // max_iters iterations, or if progress cancels it. See hasDISFReachedTarget (or the stats'
+    // has_reached_target, if the workspace is internal). Both limits are ignored if <= 0. 
+    // Default: 0
+    double time_budget;
+    int max_iters;
+    DISFProgress progress; // NULL for none. Default: NULL
+    void *progress_data; // Given to progress. Default: NULL
+    DISFStats *stats; // NULL for none. Not to be shared among concurrent runs. Default: NULL
+} DISFOptions;
+
 typedef struct
 {
     int num_cols, num_rows, num_feats, num_nodes;
-    float **feats; // Access by feats[i < num_nodes][f < num_feats]
+    FeatLayout layout;
+    float *feats; // Single buffer of num_nodes * num_feats values. See getNodeFeats
 } Graph;
 
+// Trees carried from outside the graph (e.g., from a previous band of a larger
+// image) into runDISFWithPinnedTrees
+typedef struct
+{
+    int num_trees, num_feats; // Labeled [0, num_trees[
+    float *sum_feat; // num_trees x num_feats. Of their nodes outside the graph
+    int *num_nodes; // Idem
+    int num_roots;
+    int *root_nodes, *root_labels; // Nodes within the graph, and their pinned tree
+} PinnedTrees;
+
+// Forests of every iteration of a run (i.e., levels), from the initial one to the final. Trees
+// are identified by their seed's position in the initial seed set (i.e., id), so that a node's
+// label is only stored (as a delta) when its tree changes. See getDISFHierarchyLabels
+typedef struct
+{
+    int num_rows, num_cols, num_nodes;
+    int num_levels, level_capacity;
+    int *num_superpixels; // Of each level, by decreasing quantity
+    int *base_ids; // Of each node, at level 0
+    // Level l's trees (by id) in their label order, within [seed_start[l], seed_start[l + 1][
+    int *seed_start, *seed_ids, seed_capacity;
+    // Level l's changes, within [delta_start[l], delta_start[l + 1][ (none for level 0)
+    int *delta_start, *delta_nodes, *delta_ids, delta_capacity;
+    int *curr_ids; // Of each node, at the last recorded level
+} DISFHierarchy;
+
+// Opaque. Every buffer runDISFWithWorkspace needs (e.g., cost map, queues, trees
+// and the gradient), kept among calls. See createDISFWorkspace
+typedef struct DISFWorkspace DISFWorkspace;
+
 //=============================================================================
 // Prototypes
 //=============================================================================
 NodeAdj *create4NeighAdj(); // 4-neighborhood
 NodeAdj *create8NeighAdj(); // 8-neighborhood
-Graph *createGraph(Image *img); // sRGB/Gray img --> Lab graph
+Graph *createGraph(Image *img); // sRGB/Gray img --> Lab graph (interleaved)
+Graph *createGraphWithLayout(Image *img, FeatLayout layout);
+// As createGraph, straight from a buffer of num_channels interleaved channels of the given type (e.g.,
+// of a numpy array), without an intermediate image. A pixel's channels, the pixels and the rows are
+// channel_stride, pixel_stride and row_stride bytes apart, any of them possibly negative
+Graph *createGraphFromBuffer(void *data, PixelType type, int num_rows, int num_cols, int num_channels,
+                             long row_stride, long pixel_stride, long channel_stride);
 Tree *createTree(int root_index, int num_feats); // root note is not inserted
+DISFOptions *createDISFOptions(); // Default values
+DISFStats *createDISFStats();
+// Sized for images up to max_num_rows x max_num_cols, and up to max_n_0 initial seeds. 
+// Larger inputs are still accepted, at the cost of growing it. NULL opts for defaults
+DISFWorkspace *createDISFWorkspace(int max_num_rows, int max_num_cols, int max_n_0, DISFOptions *opts);
+void freeDISFOptions(DISFOptions **opts);
+void freeDISFStats(DISFStats **stats);
+void freeDISFHierarchy(DISFHierarchy **hierarchy);
+void freeDISFWorkspace(DISFWorkspace **ws);
 void freeNodeAdj(NodeAdj **adj_rel);
 void freeTree(Tree **tree);
 void freeGraph(Graph **graph);
 
 bool areValidNodeCoords(Graph *graph, NodeCoords coords);
+// If the last run of the workspace was not stopped by the anytime limits (i.e., its result is
+// the same as without them)
+bool hasDISFReachedTarget(DISFWorkspace *ws);
 
 int getNodeIndex(Graph *graph, NodeCoords coords);
+// Level with the fewest superpixels, but at least num_superpixels (or the last level, if none)
+int getDISFHierarchyLevel(DISFHierarchy *hierarchy, int num_superpixels);
+
+float getNodeFeat(Graph *graph, int index, int feat);
 
 double euclDistance(float *feat1, float *feat2, int num_feats); // L2-norm
 double taxicabDistance(float *feat1, float *feat2, int num_feats); // L1-norm
@@ -72,17 +224,49 @@ double taxicabDistance(float *feat1, float *feat2, int num_feats); // L1-norm
 NodeCoords getAdjacentNodeCoords(NodeAdj *adj_rel, NodeCoords coords, int id);
 NodeCoords getNodeCoords(Graph *graph, int index);
 
-float* meanTreeFeatVector(Tree *tree);
+float* meanTreeFeatVector(Tree *tree); // Copy of tree->mean_feat
+// Interleaved: points into graph->feats (no copy). Planar: gathered into buffer
+float *getNodeFeats(Graph *graph, int index, float *buffer);
 
 double *computeGradient(Graph *graph);
 
-// If border_img is not desired, simply pass NULL.
+// If border_img is not desired, simply pass NULL. Otherwise, it may be of any
+// PixelType. The label image returned is int32.
 Image *runDISF(Graph *graph, int n_0, int n_f, Image **border_img);
+Image *runDISFWithOptions(Graph *graph, int n_0, int n_f, Image **border_img, DISFOptions *opts); // NULL for defaults
+// Performs no allocation in steady state (i.e., within the workspace's capacities, with 
+// the same resolution and options as before). The label image returned belongs to the 
+// workspace, and is overwritten by the next call
+Image *runDISFWithWorkspace(DISFWorkspace *ws, Graph *graph, int n_0, int n_f, Image **border_img, DISFOptions *opts);
+// The pinned roots are seeds (i.e., cost 0) of their trees, whose features start from the
+// given ones. Pinned trees are never removed, nor counted in n_f, and take the labels
+// [0, pinned->num_trees[. Only supported in the default mode (i.e., neither differential
+// nor tiled). As in runDISFWithWorkspace, otherwise
+Image *runDISFWithPinnedTrees(DISFWorkspace *ws, Graph *graph, int n_0, int n_f, Image **border_img, 
+                              DISFOptions *opts, PinnedTrees *pinned);
+// Records every iteration's forest in *hierarchy (created for the caller), whose last level is
+// the one returned. Not supported in differential mode (i.e., it is ignored). As in 
+// runDISFWithOptions, otherwise
+Image *runDISFWithHierarchy(Graph *graph, int n_0, int n_f, Image **border_img, DISFOptions *opts, 
+                            DISFHierarchy **hierarchy);
+// Label image (int32) of the level, as if the run had stopped at it
+Image *getDISFHierarchyLabels(DISFHierarchy *hierarchy, int level);
+// Temporal warm-start for videos. The image is split into cells, one per grid sample, 
+// whose mean colors are compared to those of their last sampling. The final seeds of
+// the previous call are kept within the unchanged cells, and the changed ones are 
+// re-sampled. Then, the removal schedule is resumed from the matching iteration, thus 
+// static scenes require a single IFT. The first call (or if the resolution or n_0 
+// changes) performs a full run. As in runDISFWithWorkspace, otherwise
+Image *runDISFTemporal(DISFWorkspace *ws, Graph *graph, int n_0, int n_f, Image **border_img, DISFOptions *opts);
 
-IntList *gridSampling(Graph *graph, int num_seeds);
-IntList *selectKMostRelevantSeeds(Tree **trees, IntList **tree_adj, int num_nodes, int num_trees, int num_maintain);
+IntList *gridSampling(Graph *graph, int num_seeds); // The gradient is only evaluated around each grid point
+// If grad is not NULL, the whole gradient (as computeGradient) is created in it for the caller
+IntList *gridSamplingWithGradient(Graph *graph, int num_seeds, double **grad);
+// NULL trees (i.e., removed) are ignored
+IntList *selectKMostRelevantSeeds(Tree **trees, RegionAdj *tree_adj, int num_nodes, int num_trees, int num_maintain);
 
 void insertNodeInTree(Graph *graph, int index, Tree **tree);
+void removeNodeFromTree(Graph *graph, int index, Tree **tree);
 
 
 #ifdef __cplusplus
@@ -0,0 +1,70 @@
+/**
+* Batch Segmentation
+*
+* @date October, 2026
+* @note Whole images are distributed among the threads of an OpenMP team
+*       (one image per worker at a time), each worker keeping its own
+*       DISFWorkspace among images and batches. The parallel regions within
+*       an image (e.g., createGraph) run on a single thread.
+*/
+#ifndef DISFBATCH_H
+#define DISFBATCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//=============================================================================
+// Includes
+//=============================================================================
+#include "DISF.h"
+
+//=============================================================================
+// Structures
+//=============================================================================
+// Pixels of an external (possibly strided) buffer, as given to createGraphFromBuffer
+typedef struct
+{
+    void *data;
+    PixelType type;
+    int num_rows, num_cols, num_channels;
+    long row_stride, pixel_stride, channel_stride; // In bytes
+} ImageBuffer;
+
+typedef struct
+{
+    int num_workers;
+    DISFOptions opts; // Without tiles
+    DISFWorkspace **workspaces; // One per worker
+    // Counters of the last batch. Times are in seconds
+    int num_imgs, latency_capacity;
+    double elapsed, throughput; // Wall-clock time, and images per second
+    double *latency; // Of each image (graph creation included), in input order
+    double mean_latency, max_latency;
+    // Counters since its creation
+    long total_imgs;
+    double total_elapsed;
+} DISFBatch;
+
+//=============================================================================
+// Prototypes
+//=============================================================================
+// Workspaces are sized as in createDISFWorkspace. If num_workers <= 0, the
+// maximum number of OpenMP threads is considered. NULL opts for defaults
+DISFBatch *createDISFBatch(int num_workers, int max_num_rows, int max_num_cols, int max_n_0, DISFOptions *opts);
+void freeDISFBatch(DISFBatch **batch);
+
+// Segments imgs[i] into n_f[i] superpixels, from n_0[i] seeds. The int32 label
+// images are created in label_imgs, and, if border_imgs is not NULL, the uint8
+// border images in border_imgs. Both belong to the caller
+void runDISFBatch(DISFBatch *batch, Image **imgs, int num_imgs, int *n_0, int *n_f,
+                  Image **label_imgs, Image **border_imgs);
+// As runDISFBatch, with each graph built straight from its buffer (e.g., of a numpy array)
+void runDISFBatchFromBuffers(DISFBatch *batch, ImageBuffer *bufs, int num_imgs, int *n_0, int *n_f,
+                             Image **label_imgs, Image **border_imgs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DISFBATCH_H
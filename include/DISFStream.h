@@ -0,0 +1,87 @@
+/**
+* Out-of-core (Streaming) Segmentation
+*
+* @date October, 2026
+* @note The image is pushed in rows, and segmented in horizontal bands of
+*       band_rows rows, plus overlap_rows rows of lookahead, which are only
+*       committed by the next band. The last committed row of a band is
+*       carried into the next one as the roots of pinned trees (see
+*       runDISFWithPinnedTrees), together with the features of the nodes
+*       above it, so superpixels continue across the bands. Committed rows
+*       are relabeled globally, by connected component (i.e., a tree only
+*       connected through the lookahead is split), and handed to the writer
+*       with their borders (8-neighborhood) one row later. Memory is bounded
+*       by the width and the band size, regardless of the height.
+*/
+#ifndef DISFSTREAM_H
+#define DISFSTREAM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//=============================================================================
+// Includes
+//=============================================================================
+#include "DISF.h"
+
+//=============================================================================
+// Structures
+//=============================================================================
+// Receives num_rows x num_cols labels, and borders (0 or 255), starting at the
+// image row first_row. Both buffers are overwritten after it returns
+typedef void (*DISFStreamWriter)(int first_row, int num_rows, int num_cols, int *labels,
+                                 unsigned char *borders, void *user_data);
+
+typedef struct
+{
+    int num_rows, num_cols, num_channels; // Of the whole image
+    int n_0, n_f; // Of the whole image. Bands consider the same densities
+    int band_rows, overlap_rows;
+    DISFOptions opts; // Neither differential nor tiled
+    DISFStreamWriter writer;
+    void *user_data;
+    // Band buffer: the pinned row (if any), followed by the pending ones
+    int num_pushed, num_buf_rows, buf_capacity; // In rows
+    bool has_pinned;
+    float *buf_feats; // Lab, interleaved
+    DISFWorkspace *ws;
+    PinnedTrees pinned; // Local ids, whose global labels are in pinned_labels
+    int *pinned_labels;
+    float *next_sum_feat; // Pinned trees of the next band (swapped with pinned's)
+    int *next_num_nodes, *next_pinned_labels;
+    // Components of the committed rows (and their trees' keys, i.e., local pinned id, or
+    // num_pinned + component), and the features above the next pinned row, per key
+    int *comp_map, *comp_queue, *comp_keys, *comp_labels;
+    int *pinned_map, *band_num_nodes;
+    float *band_sum_feat;
+    // Emission window: the last emitted row (if any), followed by the held ones
+    int num_labels; // Global labels assigned so far, i.e., [0, num_labels[
+    int num_emitted, num_held;
+    int *out_labels;
+    unsigned char *out_borders;
+} DISFStream;
+
+//=============================================================================
+// Prototypes
+//=============================================================================
+// If band_rows <= 0 or overlap_rows < 0, they are set from the approximate superpixel
+// side, which is also the minimum of band_rows / 2. The number of superpixels approximates
+// n_f. NULL opts for defaults
+DISFStream *createDISFStream(int num_rows, int num_cols, int num_channels, int n_0, int n_f,
+                             int band_rows, int overlap_rows, DISFOptions *opts,
+                             DISFStreamWriter writer, void *user_data);
+void freeDISFStream(DISFStream **stream);
+
+// Appends the rows of img (sRGB or gray, of any PixelType, with the stream's width and
+// channels). 8-bit values are normalized by 255, and others by 65535, since the maximum
+// of the whole image is unknown. Full bands are segmented and written meanwhile
+void pushDISFStreamRows(DISFStream *stream, Image *img);
+// Segments and writes the remaining rows. Every row must have been pushed
+void finishDISFStream(DISFStream *stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DISFSTREAM_H
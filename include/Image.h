@@ -18,24 +18,44 @@ extern "C" {
 //=============================================================================
 // Structures
 //=============================================================================
+typedef enum
+{
+    // FLOAT32_TYPE values are normalized within [0,1], and thus truncated by getImageVal
+    UINT8_TYPE, UINT16_TYPE, INT32_TYPE, FLOAT32_TYPE
+} PixelType;
+
 typedef struct
 {
     int num_cols, num_rows, num_channels, num_pixels;
-    int **val; // Access by val[i < num_pixels][f < num_channels]
+    PixelType type;
+    union
+    {
+        void *raw;
+        unsigned char *u8;
+        unsigned short *u16;
+        int *i32;
+        float *f32;
+    } val; // Single aligned buffer. Access by val.<type>[i * num_channels + f]
 } Image;
 
 //=============================================================================
 // Prototypes
 //=============================================================================
-Image *createImage(int num_rows, int num_cols, int num_channels); // Zero-filled
+Image *createImage(int num_rows, int num_cols, int num_channels); // Zero-filled, int32
+Image *createImageOfType(int num_rows, int num_cols, int num_channels, PixelType type);
 void freeImage(Image **img);
 
+int getImageVal(Image *img, int index, int channel);
 int getMaximumValue(Image *img, int channel); // For all channels, set channel = -1
 int getMinimumValue(Image *img, int channel); //
-int getNormValue(Image *img); // For 8- and 16-bit, norm is 255 and 65535
+int getNormValue(Image *img); // For 8- and 16-bit, norm is 255 and 65535. For float, 1
+
+size_t getPixelTypeSize(PixelType type);
+
+void setImageVal(Image *img, int index, int channel, int value);
 
 #ifdef __cplusplus
 }
 #endif
 
-#endif // IMAGE_H
\ No newline at end of file
+#endif // IMAGE_H
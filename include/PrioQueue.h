@@ -2,7 +2,10 @@
 * Priority Queue
 *
 * @date September, 2019
-* @note Based on the priority heap implemented by Samuel Martins
+* @note Based on the priority heap implemented by Samuel Martins. It is a d-ary
+*       heap, sifted iteratively (i.e., by moving a hole), whose entries hold a
+*       copy of their priorities. Thus, prio must be updated through the functions
+*       below (e.g., moveIndexUpPrioQueue) while the element is in the queue
 */
 #ifndef PRIOQUEUE_H
 #define PRIOQUEUE_H
@@ -14,8 +17,19 @@ extern "C" {
 //=============================================================================
 // Includes
 //=============================================================================
+#include <limits.h>
 #include "Utils.h"
 
+//=============================================================================
+// Constants
+//=============================================================================
+// Default heap arity. Four 16-byte entries fill a 64-byte cache line, and halve the
+// depth of a binary heap
+#define PRIOQUEUE_ARITY 4
+#define MAX_PRIOQUEUE_ARITY 16
+// Stamps of a generation lie within [generation, generation + STATE_GENERATION_STEP[
+#define STATE_GENERATION_STEP 4
+
 //=============================================================================
 // Structures
 //=============================================================================
@@ -30,36 +44,62 @@ typedef enum
     WHITE_STATE, GRAY_STATE, BLACK_STATE
 } ElemState;
 
+// Heap entry, whose priority is kept alongside it for locality
+typedef struct
+{
+    double key; // Priority, negated for MAXVAL_POLICY (i.e., the heap is always of minimum)
+    int index;
+} HeapElem;
+
 typedef struct 
 {
     int last_elem_pos, size;
-    int *pos, *node; // Position in the heap, and its element value
+    int arity, arity_log2; // Children per node, a power of 2
+    int *pos; // Position in the heap of each element, if GRAY_STATE
+    // Shifted by arity - 1 from an aligned buffer, so that siblings share a cache line
+    HeapElem *heap;
     double* prio; // Priority (clone)
-    ElemState* state;
+    // State of each element, stamped with its generation (i.e., generation + ElemState). Those 
+    // of past generations are WHITE_STATE, thus a reset only starts a new generation
+    unsigned int *stamp, generation;
+    // Of the i-th element at prio[i * prio_stride] and stamp[i * stamp_stride]. Both are 1, but
+    // for external records
+    int prio_stride, stamp_stride;
+    bool owns_stamp;
     RemPolicy rem_policy;
 } PrioQueue;
 
 //=============================================================================
 // Prototypes
 //=============================================================================
-PrioQueue* createPrioQueue(int size, double *prio, RemPolicy rem_policy);
+PrioQueue* createPrioQueue(int size, double *prio, RemPolicy rem_policy); // Of PRIOQUEUE_ARITY
+// The arity must be a power of 2, up to MAX_PRIOQUEUE_ARITY
+PrioQueue* createPrioQueueWithArity(int size, double *prio, RemPolicy rem_policy, int arity);
+// Of PRIOQUEUE_ARITY, whose priorities and stamps are interleaved within external records (e.g., packed
+// per-node ones), of prio_stride doubles and stamp_stride unsigned ints. The stamps are cleared, but not
+// freed. If stamp is NULL, the queue has its own (i.e., only the priorities are external)
+PrioQueue* createPrioQueueOfRecords(int size, double *prio, int prio_stride, unsigned int *stamp, int stamp_stride,
+                                    RemPolicy rem_policy);
 void freePrioQueue(PrioQueue **queue);
 
 bool insertPrioQueue(PrioQueue **queue, int index);
 bool isPrioQueueEmpty(PrioQueue *queue);
 bool isPrioQueueFull(PrioQueue *queue);
 
-int getFatherPos(int pos);
-int getLeftSonPos(int pos);
-int getRightSonPos(int pos);
+int getFatherPos(PrioQueue *queue, int pos);
+int getFirstSonPos(PrioQueue *queue, int pos); // Its siblings follow it
 int popPrioQueue(PrioQueue **queue);
 
+ElemState getPrioQueueState(PrioQueue *queue, int index);
+
 // If the removal policy and the updated value are known, it is faster to use one of both
 // functions below, than removing and re-inserting the element
 void moveIndexDownPrioQueue(PrioQueue **queue, int index); 
 void moveIndexUpPrioQueue(PrioQueue **queue, int index);   
 void removePrioQueueElem(PrioQueue **queue, int index);
-void resetPrioQueue(PrioQueue **queue);
+void resetPrioQueue(PrioQueue **queue); // O(1), but for a generation overflow
+// Of an element out of the queue (i.e., not GRAY_STATE), within the current generation
+void setPrioQueueState(PrioQueue *queue, int index, ElemState state);
 
 
 #ifdef __cplusplus
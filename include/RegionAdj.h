@@ -0,0 +1,62 @@
+/**
+* Sparse Region Adjacency
+*
+* @date October, 2026
+* @note Unordered pairs of adjacent regions are kept in an open-addressed 
+*       hash set (linear probing), and the per-region adjacency lists are 
+*       built on demand in a single CSR arena. Memory is O(num_pairs), 
+*       apart from the num_regions + 1 list offsets. Once grown, neither
+*       resetting, rebuilding nor filtering allocates memory.
+*/
+#ifndef REGIONADJ_H
+#define REGIONADJ_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//=============================================================================
+// Includes
+//=============================================================================
+#include "Utils.h"
+#include <stdint.h>
+
+//=============================================================================
+// Constants
+//=============================================================================
+#define EMPTY_REGION_PAIR UINT64_MAX
+
+//=============================================================================
+// Structures
+//=============================================================================
+typedef struct
+{
+    int num_regions, num_pairs, capacity; // Capacity is a power of 2
+    uint64_t *pairs; // (min << 32 | max), or EMPTY_REGION_PAIR
+    // Lists. The regions adjacent to r are adj_elems[adj_start[r] .. adj_start[r+1][
+    bool are_lists_built;
+    int *adj_start, *adj_elems; 
+    int elems_capacity; // Of adj_elems, which only grows
+} RegionAdj;
+
+//=============================================================================
+// Prototypes
+//=============================================================================
+RegionAdj *createRegionAdj(int num_regions);
+void freeRegionAdj(RegionAdj **adj);
+
+bool areRegionsAdj(RegionAdj *adj, int region_1, int region_2);
+bool insertRegionAdjPair(RegionAdj **adj, int region_1, int region_2); // False if already present
+
+int getRegionAdjDegree(RegionAdj *adj, int region); // Lists must be built
+
+void buildRegionAdjLists(RegionAdj **adj);
+void keepRegionAdjPairs(RegionAdj **adj, bool *is_kept); // Removes the pairs of non-kept regions
+void mergeRegionAdj(RegionAdj **adj, RegionAdj *other); // Inserts all pairs of other
+void resetRegionAdj(RegionAdj **adj);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // REGIONADJ_H
@@ -20,9 +20,29 @@ extern "C" {
 #include <stdbool.h>
 #include <math.h>
     
+//=============================================================================
+// Constants
+//=============================================================================
+#define MEM_ALIGNMENT 64 // Cache line and AVX-512 width
+
+//=============================================================================
+// Macros
+//=============================================================================
+// Runtime dispatch (GCC's function multiversioning) of vectorizable kernels, by the
+// widest instruction set of the CPU. The avx512f clone has FMA, thus contraction (GNU C's
+// default -ffp-contract=fast) is turned off, so that results do not vary among the clones
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+    #define SIMD_TARGET_CLONES __attribute__((target_clones("avx512f", "avx2", "sse4.1", "default"), \
+                                              optimize("fp-contract=off")))
+#else
+    #define SIMD_TARGET_CLONES
+#endif
+
 //=============================================================================
 // Prototypes
 //=============================================================================
+void *callocAligned(size_t num_elems, size_t elem_size); // Zero-filled. Release with free()
+
 void printError(const char* function_name, const char* message, ...); // Exits the program
 void printWarning(const char* function_name, const char* message, ...);
 
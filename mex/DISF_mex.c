@@ -111,7 +111,7 @@ Graph *createGraphFromMexArray(const mxArray *mxarray, int ndims, const mwSize *
             for(int f = 0; f < num_channels; ++f)
             {
                 int matlab_index = y + x * num_rows + f * num_rows * num_cols;
-                img->val[my_index][f] = (int)in_data[matlab_index];
+                img->val.i32[my_index * num_channels + f] = (int)in_data[matlab_index];
             }
         }
 
@@ -143,7 +143,7 @@ mxArray *createMexArrayFromGrayImage(Image *img)
             int my_index = y * img->num_cols + x;
             int matlab_index = x * img->num_rows + y;
 
-            mx_data[matlab_index] = img->val[my_index][0];
+            mx_data[matlab_index] = getImageVal(img, my_index, 0);
         }
 
     free(out_dims);
@@ -9,9 +9,18 @@
 //=============================================================================
 #include <Python.h>
 #include <numpy/arrayobject.h>
+#include <omp.h>
 
 #include "Image.h"
 #include "DISF.h"
+#include "DISFBatch.h"
+
+//=============================================================================
+// Constants
+//=============================================================================
+// Of the error of createInputPyArray
+#define INPUT_DTYPES_MSG "a uint8, uint16, int32 or float32 numpy array (used without a copy), or of a dtype " \
+                         "that can be safely cast to int32 (e.g., int16, but not float64)"
 
 //=============================================================================
 // Prototypes
@@ -19,15 +28,42 @@
 void usage();
 PyMODINIT_FUNC PyInit_disf(void);
 static PyObject* DISF_Superpixels(PyObject* self, PyObject* args);
+static PyObject* DISF_SuperpixelsBatch(PyObject* self, PyObject* args);
+static PyObject* DISF_SuperpixelsStats(PyObject* self, PyObject* args);
 
+// The array itself, if of a supported type (i.e., uint8, uint16, int32 or float32), aligned and in the 
+// native byte order. Otherwise, an int32 copy of it. NULL on error
+PyObject *createInputPyArray(PyObject *pyobj);
+PixelType getPixelTypeOfPyArray(PyObject *pyarr); // Of an array given by createInputPyArray
+// A view of the array's buffer, thus only valid while the array is
+ImageBuffer getImageBufferOfPyArray(PyObject *pyarr, int ndim, npy_intp *dims);
+// Straight from the array's buffer, without an intermediate image
 Graph *createGraphFromPyArray(PyObject *pyarr, int ndim, npy_intp *dims, Image **border_img);
-PyObject *createPyObjectFromGrayImage(Image *img);
+// Wraps the int32 image's buffer, thus taking over the image, which is freed along with the array.
+// Either way, img is NULLed. NULL on error
+PyObject *createPyObjectFromGrayImage(Image **img);
+PyObject *createPyObjectFromStats(DISFStats *stats);
+int *createSeedCountsFromPyObject(PyObject *pyobj, int num_imgs, const char *name); // NULL on error
+// Of an integer within [2,INT_MAX] (i.e., > 1, as N0 and Nf must be). False, with the error set, otherwise
+static bool getSeedCountOfPyObject(PyObject *pyobj, const char *name, int *count);
+static void freeImageCapsule(PyObject *capsule); // Destructor of the arrays' bases
+static void freeDISFModule(void *module);
+
+//=============================================================================
+// Variables
+//=============================================================================
+// Of DISF_SuperpixelsBatch, whose workspaces (grown on demand) are kept among calls. A call 
+// takes it over (holding the GIL), so that concurrent calls create their own, and gives it 
+// back, unless another was given back meanwhile
+static DISFBatch *CACHED_BATCH = NULL;
 
 //=============================================================================
 // Structures
 //=============================================================================
 static PyMethodDef methods[] = {
     { "DISF_Superpixels", DISF_Superpixels, METH_VARARGS, "Generates superpixels with the DISF algorithm" },
+    { "DISF_SuperpixelsBatch", DISF_SuperpixelsBatch, METH_VARARGS, "Generates superpixels for many images concurrently" },
+    { "DISF_SuperpixelsStats", DISF_SuperpixelsStats, METH_VARARGS, "Generates superpixels, and reports the timings and counters of each phase" },
     { NULL, NULL, 0, NULL }
 };
 
@@ -37,7 +73,11 @@ static struct PyModuleDef disfModule =
     "DISF algorithm",
     "Dynamic and Iterative Spanning Forest method for superpixel segmentation",
     -1,
-    methods
+    methods,
+    NULL,
+    NULL,
+    NULL,
+    freeDISFModule
 };
 
 //=============================================================================
@@ -48,12 +88,35 @@ void usage()
     printf("Usage: [<a>,<b>] = DISF_Superpixels(<1>,<2>,<3>)\n");
     printf("----------------------------------\n");
     printf("INPUTS:\n");
-    printf("<1> - 2D int32 grayscale/RGB numpy array\n" );
+    printf("<1> - 2D grayscale/RGB numpy array. Either uint8, uint16 or int32 (within [0,65535]), or \n");
+    printf("      float32 (within [0,1]). Any other type is safely cast to int32\n");
     printf("<2> - Initial number of seeds (e.g., N0 = 8000)\n");
     printf("<3> - Final number of superpixels (e.g., Nf = 50)\n");
     printf("OUTPUTS:\n");
     printf("<a> - 2D int32 label numpy array\n" );
     printf("<b> - 2D int32 border numpy array\n");
+    printf("\n");
+    printf("Usage: [<a>,<b>,<c>] = DISF_SuperpixelsBatch(<1>,<2>,<3>)\n");
+    printf("----------------------------------\n");
+    printf("INPUTS:\n");
+    printf("<1> - Sequence of 2D grayscale/RGB numpy arrays, as for DISF_Superpixels\n" );
+    printf("<2> - Initial number of seeds, for all or for each image\n");
+    printf("<3> - Final number of superpixels, for all or for each image\n");
+    printf("OUTPUTS:\n");
+    printf("<a> - List of 2D int32 label numpy arrays\n" );
+    printf("<b> - List of 2D int32 border numpy arrays\n");
+    printf("<c> - Dict of timings (in seconds): elapsed, throughput (images/s), \n");
+    printf("      mean_latency, max_latency and latency (per image)\n");
+    printf("\n");
+    printf("Usage: [<a>,<b>,<c>] = DISF_SuperpixelsStats(<1>,<2>,<3>)\n");
+    printf("----------------------------------\n");
+    printf("INPUTS: as DISF_Superpixels\n");
+    printf("OUTPUTS:\n");
+    printf("<a> - 2D int32 label numpy array\n" );
+    printf("<b> - 2D int32 border numpy array\n");
+    printf("<c> - Dict of statistics: graph_time, sampling_time, total_time (in seconds), peak_bytes,\n");
+    printf("      and lists (per iteration) of num_trees, ift_time, selection_time, num_pushes,\n");
+    printf("      num_pops and num_decreases\n");
 }
 
 PyMODINIT_FUNC PyInit_disf(void)
@@ -75,85 +138,446 @@ static PyObject* DISF_Superpixels(PyObject* self, PyObject* args)
         usage(); return NULL;
     }
 
-    in_arr = PyArray_FROM_OTF(in_obj, NPY_INT32, NPY_ARRAY_C_CONTIGUOUS);
-    if(in_arr == NULL) return PyErr_Format(PyExc_TypeError, "Could not convert the input data to a C contiguous int32 numpy array!");
+    in_arr = createInputPyArray(in_obj);
+    if(in_arr == NULL) return PyErr_Format(PyExc_TypeError, "The image must be %s!", INPUT_DTYPES_MSG);
+
+    if(n_0 <= 1 || n_f <= 1 || n_0 < n_f)
+    {
+        Py_DECREF(in_arr);
 
-    if(n_0 <= 1) 
-        return PyErr_Format(PyExc_ValueError, "N0 must be > 1!");
-    if(n_f <= 1) 
-        return PyErr_Format(PyExc_ValueError, "Nf must be > 1!");
-    if(n_0 < n_f) 
+        if(n_0 <= 1) return PyErr_Format(PyExc_ValueError, "N0 must be > 1!");
+        if(n_f <= 1) return PyErr_Format(PyExc_ValueError, "Nf must be > 1!");
         return PyErr_Format(PyExc_ValueError, "N0 must be >> Nf!");
+    }
     
-    ndim = PyArray_NDIM(in_arr);
-    dims = (npy_intp *)PyArray_DIMS(in_arr);
+    ndim = PyArray_NDIM((PyArrayObject*)in_arr);
+    dims = (npy_intp *)PyArray_DIMS((PyArrayObject*)in_arr);
 
-    if(ndim < 2 || ndim > 3) return PyErr_Format(PyExc_Exception, "The number of dimensions must be either 2 or 3!");
-    if(ndim == 3 && dims[2] != 3) PyErr_Format(PyExc_Exception, "The image must be RGB-colored (i.e., 3 channels)");
+    if(ndim < 2 || ndim > 3 || (ndim == 3 && dims[2] != 3))
+    {
+        Py_DECREF(in_arr);
 
+        if(ndim < 2 || ndim > 3) return PyErr_Format(PyExc_Exception, "The number of dimensions must be either 2 or 3!");
+        return PyErr_Format(PyExc_Exception, "The image must be RGB-colored (i.e., 3 channels)");
+    }
+
+    // No Python object is touched, but for reading the (referenced) input array's fields
+    Py_BEGIN_ALLOW_THREADS
     graph = createGraphFromPyArray(in_arr, ndim, dims, &border_img);
 
     label_img = runDISF(graph, n_0, n_f, &border_img);
     freeGraph(&graph);
-    
-    label_obj = createPyObjectFromGrayImage(label_img);
-    border_obj = createPyObjectFromGrayImage(border_img);
+    Py_END_ALLOW_THREADS
     
     Py_DECREF(in_arr);
-    Py_INCREF(label_obj);
-    Py_INCREF(border_obj);
 
-    freeImage(&label_img);
-    freeImage(&border_img);
+    label_obj = createPyObjectFromGrayImage(&label_img);
+    border_obj = createPyObjectFromGrayImage(&border_img);
 
-    return Py_BuildValue("OO",label_obj,border_obj);
+    // The references are stolen by the tuple
+    return Py_BuildValue("NN", label_obj, border_obj);
 }
 
-Graph *createGraphFromPyArray(PyObject *pyarr, int ndim, npy_intp *dims, Image **border_img)
+static PyObject* DISF_SuperpixelsBatch(PyObject* self, PyObject* args)
 {
-    int num_cols, num_rows, num_channels;
-    Graph *graph;
-    Image *img;
+    bool valid;
+    int num_imgs, max_num_rows, max_num_cols, max_n_0;
+    int *n_0, *n_f;
+    Image **label_imgs, **border_imgs;
+    ImageBuffer *bufs;
+    DISFBatch *batch;
+    PyObject **in_arrs; // Kept until the batch ends, as its buffers are read
+    PyObject *in_seq, *n_0_obj, *n_f_obj, *label_list, *border_list, *latency_list, *stats;
 
-    num_rows = dims[0]; num_cols = dims[1];
+    if(!PyArg_ParseTuple(args, "OOO", &in_seq, &n_0_obj, &n_f_obj))
+    {
+        usage(); return NULL;
+    }
 
-    if(ndim == 2) num_channels = 1;
-    else num_channels = 3;
+    if(!PySequence_Check(in_seq)) 
+        return PyErr_Format(PyExc_TypeError, "The images must be given within a sequence!");
 
-    img = createImage(num_rows, num_cols, num_channels);
-    (*border_img) = createImage(num_rows, num_cols, 1);
+    num_imgs = (int)PySequence_Size(in_seq);
+    if(num_imgs < 1) 
+        return PyErr_Format(PyExc_ValueError, "At least one image must be given!");
 
-    #pragma omp parallel for
-    for(int y = 0; y < img->num_rows; ++y)
-        for(int x = 0; x < img->num_cols; ++x)
-            for(int f = 0; f < img->num_channels; ++f)
-                img->val[x + num_cols * y][f] = *(int*)(PyArray_GETPTR3(pyarr, y, x, f));
+    n_0 = createSeedCountsFromPyObject(n_0_obj, num_imgs, "N0");
+    if(n_0 == NULL) return NULL;
 
-    graph = createGraph(img);
+    n_f = createSeedCountsFromPyObject(n_f_obj, num_imgs, "Nf");
+    if(n_f == NULL) { free(n_0); return NULL; }
 
-    freeImage(&img);
+    in_arrs = (PyObject**)calloc(num_imgs, sizeof(PyObject*));
+    bufs = (ImageBuffer*)calloc(num_imgs, sizeof(ImageBuffer));
+    valid = true;
+    max_num_rows = max_num_cols = max_n_0 = 0;
+
+    for(int i = 0; i < num_imgs && valid; i++)
+    {
+        int ndim;
+        PyObject *item, *in_arr;
+        npy_intp *dims;
+
+        if(n_0[i] < n_f[i])
+        {
+            PyErr_Format(PyExc_ValueError, "N0 must be >> Nf (image %d)!", i);
+            valid = false; break;
+        }
+
+        item = PySequence_GetItem(in_seq, i);
+        in_arr = item == NULL ? NULL : createInputPyArray(item);
+        Py_XDECREF(item);
+
+        if(in_arr == NULL)
+        {
+            PyErr_Format(PyExc_TypeError, "The image %d must be %s!", i, INPUT_DTYPES_MSG);
+            valid = false; break;
+        }
+
+        ndim = PyArray_NDIM((PyArrayObject*)in_arr);
+        dims = (npy_intp *)PyArray_DIMS((PyArrayObject*)in_arr);
+
+        if(ndim < 2 || ndim > 3 || (ndim == 3 && dims[2] != 3))
+        {
+            PyErr_Format(PyExc_Exception, "The image %d must be either 2D, or 3D with 3 channels!", i);
+            valid = false;
+        }
+        else
+        {
+            bufs[i] = getImageBufferOfPyArray(in_arr, ndim, dims);
+
+            max_num_rows = MAX(max_num_rows, bufs[i].num_rows);
+            max_num_cols = MAX(max_num_cols, bufs[i].num_cols);
+            max_n_0 = MAX(max_n_0, n_0[i]);
+        }
+
+        in_arrs[i] = in_arr;
+    }
 
-    return graph;
+    label_list = border_list = stats = NULL;
+
+    if(valid)
+    {
+        label_imgs = (Image**)calloc(num_imgs, sizeof(Image*));
+        border_imgs = (Image**)calloc(num_imgs, sizeof(Image*));
+
+        batch = CACHED_BATCH;
+        CACHED_BATCH = NULL;
+
+        Py_BEGIN_ALLOW_THREADS
+        if(batch == NULL) batch = createDISFBatch(0, max_num_rows, max_num_cols, max_n_0, NULL);
+        runDISFBatchFromBuffers(batch, bufs, num_imgs, n_0, n_f, label_imgs, border_imgs);
+        Py_END_ALLOW_THREADS
+
+        label_list = PyList_New(num_imgs);
+        border_list = PyList_New(num_imgs);
+        latency_list = PyList_New(num_imgs);
+
+        for(int i = 0; i < num_imgs; i++)
+        {
+            // The references are stolen by the lists
+            PyList_SET_ITEM(label_list, i, createPyObjectFromGrayImage(&(label_imgs[i])));
+            PyList_SET_ITEM(border_list, i, createPyObjectFromGrayImage(&(border_imgs[i])));
+            PyList_SET_ITEM(latency_list, i, PyFloat_FromDouble(batch->latency[i]));
+        }
+
+        stats = Py_BuildValue("{s:d,s:d,s:d,s:d,s:N}", "elapsed", batch->elapsed, "throughput", batch->throughput,
+                              "mean_latency", batch->mean_latency, "max_latency", batch->max_latency, 
+                              "latency", latency_list);
+
+        if(CACHED_BATCH == NULL) CACHED_BATCH = batch;
+        else freeDISFBatch(&batch);
+        free(label_imgs);
+        free(border_imgs);
+    }
+
+    for(int i = 0; i < num_imgs; i++)
+        Py_XDECREF(in_arrs[i]);
+    free(in_arrs);
+    free(bufs);
+    free(n_0);
+    free(n_f);
+
+    if(!valid) return NULL;
+
+    return Py_BuildValue("NNN", label_list, border_list, stats);
 }
 
-PyObject *createPyObjectFromGrayImage(Image *img)
+static PyObject* DISF_SuperpixelsStats(PyObject* self, PyObject* args)
 {
+    int n_0, n_f, ndim;
+    double start;
+    Image *label_img, *border_img;
+    Graph *graph;
+    DISFOptions *opts;
+    PyObject *in_obj, *in_arr, *stats_obj;
     npy_intp *dims;
-    PyObject *pyobj;
 
-    dims = (npy_intp *)malloc(2 * sizeof(npy_intp));
-    dims[0] = img->num_rows; dims[1] = img->num_cols;
-    pyobj = (PyObject *)PyArray_SimpleNew(2, dims, PyArray_INT);
+    if(!PyArg_ParseTuple(args, "O!ii", &PyArray_Type, &in_obj, &n_0, &n_f))
+    {
+        usage(); return NULL;
+    }
+
+    in_arr = createInputPyArray(in_obj);
+    if(in_arr == NULL) return PyErr_Format(PyExc_TypeError, "The image must be %s!", INPUT_DTYPES_MSG);
 
-    #pragma omp parallel for
-    for(int y = 0; y < img->num_rows; ++y)
-        for(int x = 0; x < img->num_cols; ++x)
+    if(n_0 <= 1 || n_f <= 1 || n_0 < n_f)
+    {
+        Py_DECREF(in_arr);
+        return PyErr_Format(PyExc_ValueError, "N0 and Nf must be > 1, and N0 >> Nf!");
+    }
+
+    ndim = PyArray_NDIM((PyArrayObject*)in_arr);
+    dims = (npy_intp *)PyArray_DIMS((PyArrayObject*)in_arr);
+
+    if(ndim < 2 || ndim > 3 || (ndim == 3 && dims[2] != 3))
+    {
+        Py_DECREF(in_arr);
+        return PyErr_Format(PyExc_Exception, "The image must be either 2D, or 3D with 3 channels!");
+    }
+
+    opts = createDISFOptions();
+    opts->stats = createDISFStats();
+
+    // No Python object is touched, but for reading the (referenced) input array's fields
+    Py_BEGIN_ALLOW_THREADS
+    start = omp_get_wtime();
+    graph = createGraphFromPyArray(in_arr, ndim, dims, &border_img);
+    opts->stats->graph_time = omp_get_wtime() - start;
+
+    label_img = runDISFWithOptions(graph, n_0, n_f, &border_img, opts);
+    freeGraph(&graph);
+    Py_END_ALLOW_THREADS
+
+    Py_DECREF(in_arr);
+
+    stats_obj = createPyObjectFromStats(opts->stats);
+
+    freeDISFStats(&(opts->stats));
+    freeDISFOptions(&opts);
+
+    // The references are stolen by the tuple
+    return Py_BuildValue("NNN", createPyObjectFromGrayImage(&label_img), createPyObjectFromGrayImage(&border_img), 
+                         stats_obj);
+}
+
+PyObject *createInputPyArray(PyObject *pyobj)
+{
+    PyArrayObject *arr;
+
+    if(!PyArray_Check(pyobj)) return PyArray_FROM_OTF(pyobj, NPY_INT32, NPY_ARRAY_ALIGNED);
+
+    arr = (PyArrayObject*)pyobj;
+
+    switch(PyArray_TYPE(arr))
+    {
+        case NPY_UINT8: case NPY_UINT16: case NPY_INT32: case NPY_FLOAT32:
+            if(PyArray_ISALIGNED(arr) && PyArray_ISNOTSWAPPED(arr))
+            {
+                Py_INCREF(pyobj); // As a new reference, alike the copies'
+                return pyobj;
+            }
+            break;
+    }
+
+    return PyArray_FROM_OTF(pyobj, NPY_INT32, NPY_ARRAY_ALIGNED);
+}
+
+PixelType getPixelTypeOfPyArray(PyObject *pyarr)
+{
+    switch(PyArray_TYPE((PyArrayObject*)pyarr))
+    {
+        case NPY_UINT8: return UINT8_TYPE;
+        case NPY_UINT16: return UINT16_TYPE;
+        case NPY_FLOAT32: return FLOAT32_TYPE;
+        default: return INT32_TYPE;
+    }
+}
+
+ImageBuffer getImageBufferOfPyArray(PyObject *pyarr, int ndim, npy_intp *dims)
+{
+    npy_intp *strides;
+    ImageBuffer buf;
+
+    strides = PyArray_STRIDES((PyArrayObject*)pyarr);
+
+    buf.data = PyArray_DATA((PyArrayObject*)pyarr);
+    buf.type = getPixelTypeOfPyArray(pyarr);
+    buf.num_rows = dims[0]; buf.num_cols = dims[1];
+    buf.row_stride = strides[0]; buf.pixel_stride = strides[1];
+
+    if(ndim == 2) { buf.num_channels = 1; buf.channel_stride = PyArray_ITEMSIZE((PyArrayObject*)pyarr); }
+    else { buf.num_channels = 3; buf.channel_stride = strides[2]; }
+
+    return buf;
+}
+
+Graph *createGraphFromPyArray(PyObject *pyarr, int ndim, npy_intp *dims, Image **border_img)
+{
+    ImageBuffer buf;
+
+    buf = getImageBufferOfPyArray(pyarr, ndim, dims);
+
+    (*border_img) = createImage(buf.num_rows, buf.num_cols, 1);
+
+    return createGraphFromBuffer(buf.data, buf.type, buf.num_rows, buf.num_cols, buf.num_channels, buf.row_stride,
+                                 buf.pixel_stride, buf.channel_stride);
+}
+
+PyObject *createPyObjectFromGrayImage(Image **img)
+{
+    npy_intp dims[2];
+    Image *tmp;
+    PyObject *pyobj, *capsule;
+
+    tmp = *img;
+    *img = NULL;
+
+    dims[0] = tmp->num_rows; dims[1] = tmp->num_cols;
+
+    if(tmp->type != INT32_TYPE) // Copied
+    {
+        pyobj = PyArray_SimpleNew(2, dims, NPY_INT32);
+
+        if(pyobj != NULL)
         {
-            int *ptr = (int*)PyArray_GETPTR2(pyobj, y, x);
-            *ptr = img->val[x + y*img->num_cols][0];
+            int *data;
+
+            data = (int*)PyArray_DATA((PyArrayObject*)pyobj);
+
+            for(int i = 0; i < tmp->num_pixels; i++)
+                data[i] = getImageVal(tmp, i, 0);
         }
 
-    free(dims);
+        freeImage(&tmp);
+
+        return pyobj;
+    }
+
+    // Both are row-major, single-channel buffers
+    pyobj = PyArray_SimpleNewFromData(2, dims, NPY_INT32, tmp->val.i32);
+    capsule = pyobj == NULL ? NULL : PyCapsule_New(tmp, NULL, freeImageCapsule);
+
+    if(capsule == NULL)
+    {
+        Py_XDECREF(pyobj);
+        freeImage(&tmp);
+
+        return NULL;
+    }
+
+    // The reference is stolen by the array, even on failure
+    if(PyArray_SetBaseObject((PyArrayObject*)pyobj, capsule) != 0)
+    {
+        Py_DECREF(pyobj);
+
+        return NULL;
+    }
 
     return pyobj;
-}
\ No newline at end of file
+}
+
+int *createSeedCountsFromPyObject(PyObject *pyobj, int num_imgs, const char *name)
+{
+    int *counts;
+
+    counts = (int*)calloc(num_imgs, sizeof(int));
+
+    if(PyLong_Check(pyobj)) // Same for all
+    {
+        int count;
+
+        if(getSeedCountOfPyObject(pyobj, name, &count))
+        {
+            for(int i = 0; i < num_imgs; i++)
+                counts[i] = count;
+        }
+        else { free(counts); counts = NULL; }
+    }
+    else if(PySequence_Check(pyobj) && PySequence_Size(pyobj) == num_imgs)
+    {
+        for(int i = 0; i < num_imgs && counts != NULL; i++)
+        {
+            PyObject *item;
+
+            item = PySequence_GetItem(pyobj, i);
+
+            if(item == NULL || !PyLong_Check(item))
+            {
+                PyErr_Format(PyExc_TypeError, "%s must only contain integers!", name);
+                free(counts); counts = NULL;
+            }
+            else if(!getSeedCountOfPyObject(item, name, &(counts[i]))) { free(counts); counts = NULL; }
+
+            Py_XDECREF(item);
+        }
+    }
+    else
+    {
+        PyErr_Format(PyExc_TypeError, "%s must be an integer, or a sequence with one per image!", name);
+        free(counts); counts = NULL;
+    }
+
+    return counts;
+}
+
+static bool getSeedCountOfPyObject(PyObject *pyobj, const char *name, int *count)
+{
+    long value;
+
+    value = PyLong_AsLong(pyobj);
+
+    // -1 with an error set if overflown
+    if((value == -1 && PyErr_Occurred()) || value < 2 || value > INT_MAX)
+    {
+        PyErr_Format(PyExc_ValueError, "%s must be within [2,%d]!", name, INT_MAX);
+        return false;
+    }
+
+    *count = (int)value;
+
+    return true;
+}
+
+PyObject *createPyObjectFromStats(DISFStats *stats)
+{
+    PyObject *num_trees, *ift_time, *selection_time, *num_pushes, *num_pops, *num_decreases;
+
+    num_trees = PyList_New(stats->num_iters);
+    ift_time = PyList_New(stats->num_iters);
+    selection_time = PyList_New(stats->num_iters);
+    num_pushes = PyList_New(stats->num_iters);
+    num_pops = PyList_New(stats->num_iters);
+    num_decreases = PyList_New(stats->num_iters);
+
+    for(int i = 0; i < stats->num_iters; i++)
+    {
+        // The references are stolen by the lists
+        PyList_SET_ITEM(num_trees, i, PyLong_FromLong(stats->num_trees[i]));
+        PyList_SET_ITEM(ift_time, i, PyFloat_FromDouble(stats->ift_time[i]));
+        PyList_SET_ITEM(selection_time, i, PyFloat_FromDouble(stats->selection_time[i]));
+        PyList_SET_ITEM(num_pushes, i, PyLong_FromLong(stats->num_pushes[i]));
+        PyList_SET_ITEM(num_pops, i, PyLong_FromLong(stats->num_pops[i]));
+        PyList_SET_ITEM(num_decreases, i, PyLong_FromLong(stats->num_decreases[i]));
+    }
+
+    return Py_BuildValue("{s:d,s:d,s:d,s:n,s:N,s:N,s:N,s:N,s:N,s:N}", "graph_time", stats->graph_time, 
+                         "sampling_time", stats->sampling_time, "total_time", stats->total_time, 
+                         "peak_bytes", (Py_ssize_t)stats->peak_bytes, "num_trees", num_trees, "ift_time", ift_time, 
+                         "selection_time", selection_time, "num_pushes", num_pushes, "num_pops", num_pops, 
+                         "num_decreases", num_decreases);
+}
+
+static void freeImageCapsule(PyObject *capsule)
+{
+    Image *img;
+
+    img = (Image*)PyCapsule_GetPointer(capsule, NULL);
+
+    freeImage(&img);
+}
+
+static void freeDISFModule(void *module)
+{
+    freeDISFBatch(&CACHED_BATCH);
+}
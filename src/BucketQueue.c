@@ -0,0 +1,251 @@
+#include "BucketQueue.h"
+
+//=============================================================================
+// Private Prototypes
+//=============================================================================
+// If stamp is NULL, the queue allocates its own stamps
+static BucketQueue *createBucketQueueOfStride(int size, double *prio, int prio_stride, unsigned int *stamp, 
+                                              int stamp_stride, double max_prio, double step);
+
+//=============================================================================
+// Constructors & Deconstructors
+//=============================================================================
+BucketQueue *createBucketQueue(int size, double *prio, double max_prio, double step)
+{
+    if(step <= 0)
+        printError("createBucketQueue", "The quantization step must be positive");
+
+    return createBucketQueueOfStride(size, prio, 1, NULL, 1, max_prio, step);
+}
+
+BucketQueue *createBucketQueueOfRecords(int size, double *prio, int prio_stride, unsigned int *stamp, 
+                                        int stamp_stride, double max_prio, double step)
+{
+    if(step <= 0)
+        printError("createBucketQueueOfRecords", "The quantization step must be positive");
+
+    if(prio_stride < 1 || stamp_stride < 1)
+        printError("createBucketQueueOfRecords", "The strides must be positive");
+
+    return createBucketQueueOfStride(size, prio, prio_stride, stamp, stamp_stride, max_prio, step);
+}
+
+static BucketQueue *createBucketQueueOfStride(int size, double *prio, int prio_stride, unsigned int *stamp, 
+                                              int stamp_stride, double max_prio, double step)
+{
+    BucketQueue *queue;
+
+    queue = (BucketQueue*)calloc(1, sizeof(BucketQueue));
+
+    queue->size = size;
+    queue->prio = prio;
+    queue->prio_stride = prio_stride;
+    queue->step = step;
+    queue->num_buckets = (int)(max_prio / step) + 2; // Last one holds the overflow
+    queue->num_elems = 0;
+    queue->curr_bucket = 0;
+
+    queue->first = (int*)calloc(queue->num_buckets, sizeof(int));
+    queue->last = (int*)calloc(queue->num_buckets, sizeof(int));
+    queue->next = (int*)calloc(size, sizeof(int));
+    queue->prev = (int*)calloc(size, sizeof(int));
+    queue->bucket = (int*)calloc(size, sizeof(int));
+    queue->owns_stamp = stamp == NULL;
+    queue->stamp_stride = stamp_stride;
+    queue->generation = 0;
+
+    if(queue->owns_stamp)
+        queue->stamp = (unsigned int*)calloc(size, sizeof(unsigned int)); // WHITE_STATE of generation 0
+    else
+    {
+        queue->stamp = stamp;
+
+        for(int i = 0; i < size; i++)
+            queue->stamp[i * stamp_stride] = 0;
+    }
+
+    for(int i = 0; i < queue->num_buckets; i++)
+        queue->first[i] = queue->last[i] = -1;
+
+    return queue;
+}
+
+void freeBucketQueue(BucketQueue **queue)
+{
+    if(*queue != NULL)
+    {
+        BucketQueue *tmp;
+
+        tmp = *queue;
+
+        free(tmp->first);
+        free(tmp->last);
+        free(tmp->next);
+        free(tmp->prev);
+        free(tmp->bucket);
+        if(tmp->owns_stamp) free(tmp->stamp);
+        free(tmp);
+
+        *queue = NULL;
+    }
+}
+
+//=============================================================================
+// Bool
+//=============================================================================
+bool insertBucketQueue(BucketQueue **queue, int index)
+{
+    bool success;
+
+    if((*queue)->num_elems == (*queue)->size)
+    {
+        printWarning("insertBucketQueue", "The queue is full");
+        success = false;
+    }
+    else
+    {
+        int bucket;
+        BucketQueue *tmp;
+
+        tmp = *queue;
+
+        bucket = getBucketOfPrio(tmp, tmp->prio[index * tmp->prio_stride]);
+
+        // Non-monotone insertion. Still correct, but the O(1) pop is lost
+        if(bucket < tmp->curr_bucket) tmp->curr_bucket = bucket;
+
+        // Appended at the tail (FIFO tie-breaking)
+        tmp->bucket[index] = bucket;
+        tmp->next[index] = -1;
+        tmp->prev[index] = tmp->last[bucket];
+
+        if(tmp->last[bucket] == -1) tmp->first[bucket] = index;
+        else tmp->next[tmp->last[bucket]] = index;
+
+        tmp->last[bucket] = index;
+        tmp->stamp[index * tmp->stamp_stride] = tmp->generation + GRAY_STATE; // Newly inserted
+        tmp->num_elems++;
+
+        success = true;
+    }
+
+    return success;
+}
+
+inline bool isBucketQueueEmpty(BucketQueue *queue)
+{
+    return queue->num_elems == 0;
+}
+
+//=============================================================================
+// ElemState
+//=============================================================================
+inline ElemState getBucketQueueState(BucketQueue *queue, int index)
+{
+    unsigned int stamp;
+
+    stamp = queue->stamp[index * queue->stamp_stride];
+
+    // Every element of a past generation is WHITE_STATE
+    return stamp >= queue->generation ? (ElemState)(stamp - queue->generation) : WHITE_STATE;
+}
+
+//=============================================================================
+// Int
+//=============================================================================
+inline int getBucketOfPrio(BucketQueue *queue, double prio)
+{
+    double bucket;
+
+    bucket = prio / queue->step;
+
+    if(bucket >= queue->num_buckets - 1) return queue->num_buckets - 1;
+    else if(bucket <= 0) return 0;
+    else return (int)bucket;
+}
+
+int popBucketQueue(BucketQueue **queue)
+{
+    int index;
+
+    if(isBucketQueueEmpty(*queue))
+    {
+        printWarning("popBucketQueue", "The queue is empty");
+        index = -1;
+    }
+    else
+    {
+        BucketQueue *tmp;
+
+        tmp = *queue;
+
+        while(tmp->first[tmp->curr_bucket] == -1)
+            tmp->curr_bucket++;
+
+        index = tmp->first[tmp->curr_bucket];
+
+        removeBucketQueueElem(queue, index);
+        tmp->stamp[index * tmp->stamp_stride] = tmp->generation + BLACK_STATE; // Orderly removed
+    }
+
+    return index;
+}
+
+//=============================================================================
+// Void
+//=============================================================================
+void moveIndexBucketQueue(BucketQueue **queue, int index)
+{
+    removeBucketQueueElem(queue, index);
+    insertBucketQueue(queue, index);
+}
+
+void removeBucketQueueElem(BucketQueue **queue, int index)
+{
+    BucketQueue *tmp;
+
+    tmp = *queue;
+
+    if(getBucketQueueState(tmp, index) == GRAY_STATE)
+    {
+        int bucket;
+
+        bucket = tmp->bucket[index];
+
+        if(tmp->prev[index] == -1) tmp->first[bucket] = tmp->next[index];
+        else tmp->next[tmp->prev[index]] = tmp->next[index];
+
+        if(tmp->next[index] == -1) tmp->last[bucket] = tmp->prev[index];
+        else tmp->prev[tmp->next[index]] = tmp->prev[index];
+
+        tmp->stamp[index * tmp->stamp_stride] = tmp->generation + WHITE_STATE; // Non-orderly removed
+        tmp->num_elems--;
+    }
+}
+
+void resetBucketQueue(BucketQueue **queue)
+{
+    BucketQueue *tmp;
+
+    tmp = *queue;
+
+    for(int i = 0; i < tmp->num_buckets; i++)
+        tmp->first[i] = tmp->last[i] = -1;
+
+    // Only on overflow, the stamps are cleared to WHITE_STATE of generation 0
+    if(tmp->generation > UINT_MAX - 2 * STATE_GENERATION_STEP)
+    {
+        for(int i = 0; i < tmp->size; i++)
+            tmp->stamp[i * tmp->stamp_stride] = 0;
+        tmp->generation = 0;
+    }
+    else tmp->generation += STATE_GENERATION_STEP;
+
+    tmp->num_elems = 0;
+    tmp->curr_bucket = 0;
+}
+
+inline void setBucketQueueState(BucketQueue *queue, int index, ElemState state)
+{
+    queue->stamp[index * queue->stamp_stride] = queue->generation + state;
+}
@@ -1,5 +1,38 @@
 #include "Color.h"
 
+#include <stdatomic.h>
+
+//=============================================================================
+// Constants
+//=============================================================================
+// Bits of the smallest float >= 8.85645167903563082e-3 (i.e., labFunc's threshold)
+#define LAB_FUNC_THRESHOLD_BITS 0x3c111aa7
+
+//=============================================================================
+// Structures
+//=============================================================================
+typedef union
+{
+    float f;
+    int i;
+} FloatBits;
+
+//=============================================================================
+// Variables
+//=============================================================================
+// Built once, on demand, by getsRGBGammaLUT. Atomic, so that only their building is locked
+static float *_Atomic SRGB_8BIT_LUT = NULL;
+static float *_Atomic SRGB_16BIT_LUT = NULL;
+
+//=============================================================================
+// Prototypes
+//=============================================================================
+static void convertLinearRGBToLabInto(float r, float g, float b, float *lab, int stride);
+// Converts n <= COLOR_BLOCK_SIZE linear RGB values (i.e., gamma corrected) into the l, a and
+// b buffers. Its loops are vectorized within each clone. As none contracts into FMAs (see
+// SIMD_TARGET_CLONES), the results match the scalar path's, if it is not built for FMA either
+static void convertLinearRGBBlockToLab(float *r, float *g, float *b, int n, float *l, float *a, float *bb);
+
 //=============================================================================
 // Float
 //=============================================================================
@@ -17,14 +50,78 @@ inline float gammaCorr(float value)
 
 inline float labFunc(float value)
 {
-    float new_value;
+    int is_cube_root;
+    FloatBits in, cube_root, linear, new_value;
 
-    if(value >= 8.85645167903563082e-3)
-        new_value = pow(value, 0.333333333333333);
-    else
-        new_value = (value * 841.0/108.0) + (4.0/29.0);
+    in.f = value;
+    cube_root.f = fastCbrt(value);
+    linear.f = (value * 841.0/108.0) + (4.0/29.0);
 
-    return new_value;
+    // Bitwise selection of both (i.e., branchless), so that batches are vectorized. The
+    // threshold's bits are compared as ints, whose order is the same for floats >= 0
+    is_cube_root = -(in.i >= LAB_FUNC_THRESHOLD_BITS);
+    new_value.i = (cube_root.i & is_cube_root) | (linear.i & ~is_cube_root);
+
+    return new_value.f;
+}
+
+inline float fastCbrt(float value)
+{
+    FloatBits in, guess, root_bits;
+    double root, cube;
+
+    // Initial guess (~5% off) by dividing the exponent by 3
+    in.f = value;
+    guess.i = (int)((unsigned int)in.i/3 + 709921077);
+    root = guess.f;
+
+    // Halley's method triples the correct digits at each step. In double, so 
+    // that the result rounds as pow's
+    for(int i = 0; i < 2; i++)
+    {
+        cube = root * root * root;
+        root = root * (cube + 2.0 * value)/(2.0 * cube + value);
+    }
+
+    root_bits.f = root;
+    root_bits.i &= -(in.i > 0); // 0 for value <= 0, without branching
+
+    return root_bits.f;
+}
+
+//=============================================================================
+// Const Float*
+//=============================================================================
+const float *getsRGBGammaLUT(int normval)
+{
+    float *curr_lut;
+    float *_Atomic *lut;
+
+    if(normval == 255) lut = &SRGB_8BIT_LUT;
+    else if(normval == 65535) lut = &SRGB_16BIT_LUT;
+    else return NULL;
+
+    curr_lut = atomic_load_explicit(lut, memory_order_acquire);
+
+    if(curr_lut == NULL) // Only the first calls
+    {
+        #pragma omp critical(srgb_gamma_lut)
+        {
+            curr_lut = atomic_load_explicit(lut, memory_order_relaxed);
+
+            if(curr_lut == NULL)
+            {
+                curr_lut = (float*)calloc(normval + 1, sizeof(float));
+
+                for(int i = 0; i <= normval; i++)
+                    curr_lut[i] = gammaCorr(i * 1.0/(float)normval);
+
+                atomic_store_explicit(lut, curr_lut, memory_order_release);
+            }
+        }
+    }
+
+    return curr_lut;
 }
 
 //=============================================================================
@@ -32,46 +129,161 @@ inline float labFunc(float value)
 //=============================================================================
 float *convertGrayToLab(int* gray, int normval)
 {
-    int *srgb;
     float *lab;
 
-    srgb = (int*)calloc(3, sizeof(int));
+    lab = (float*)calloc(3, sizeof(float));
 
-    srgb[0] = srgb[1] = srgb[2] = gray[0];
+    convertGrayToLabInto(gray, normval, lab, 1);
+
+    return lab;
+}
+
+float *convertsRGBToLab(int* srgb, int normval)
+{
+    float *lab;
 
-    lab = convertsRGBToLab(srgb, normval);
+    lab = (float*)calloc(3, sizeof(float));
 
-    free(srgb);
+    convertsRGBToLabInto(srgb, normval, lab, 1);
 
     return lab;
 }
 
-float *convertsRGBToLab(int* srgb, int normval)
+//=============================================================================
+// Void
+//=============================================================================
+void convertGrayToLabInto(int* gray, int normval, float *lab, int stride)
 {
-    float r, g, b, x, y, z;
-    float *xyz, *lab;
+    int srgb[3];
+
+    srgb[0] = srgb[1] = srgb[2] = gray[0];
+
+    convertsRGBToLabInto(srgb, normval, lab, stride);
+}
 
-    xyz = (float*)calloc(3, sizeof(float));
+void convertsRGBToLabInto(int* srgb, int normval, float *lab, int stride)
+{
+    float r, g, b;
 
     r = gammaCorr(srgb[0] * 1.0/(float)normval);
     g = gammaCorr(srgb[1] * 1.0/(float)normval);
     b = gammaCorr(srgb[2] * 1.0/(float)normval);
 
-    xyz[0] = r * 0.4123955889674142161 + g * 0.3575834307637148171 + b * 0.1804926473817015735;
-    xyz[1] = r * 0.2125862307855955516 + g * 0.7151703037034108499 + b * 0.07220049864333622685;
-    xyz[2] = r * 0.01929721549174694484 + g * 0.1191838645808485318 + b * 0.9504971251315797660;
+    convertLinearRGBToLabInto(r, g, b, lab, stride);
+}
 
-    lab = (float*)calloc(3, sizeof(float));
+void convertGrayToLabFromLUT(int* gray, const float *gamma_lut, float *lab, int stride)
+{
+    float value;
+
+    value = gamma_lut[gray[0]];
+
+    convertLinearRGBToLabInto(value, value, value, lab, stride);
+}
+
+void convertsRGBToLabFromLUT(int* srgb, const float *gamma_lut, float *lab, int stride)
+{
+    convertLinearRGBToLabInto(gamma_lut[srgb[0]], gamma_lut[srgb[1]], gamma_lut[srgb[2]], lab, stride);
+}
+
+static inline void convertLinearRGBToLabInto(float r, float g, float b, float *lab, int stride)
+{
+    float x, y, z;
+    float xyz[3];
+
+    for(int j = 0; j < 3; j++)
+        xyz[j] = r * SRGB_TO_XYZ[j][0] + g * SRGB_TO_XYZ[j][1] + b * SRGB_TO_XYZ[j][2];
 
     x = labFunc(xyz[0]/D65_WHITE[0]);
     y = labFunc(xyz[1]/D65_WHITE[1]);
     z = labFunc(xyz[2]/D65_WHITE[2]);
 
     lab[0] = (116.0 * y) - 16.0;
-    lab[1] = 500.0 * (x - y);
-    lab[2] = 200.0 * (y - z);
+    lab[stride] = 500.0 * (x - y);
+    lab[2 * stride] = 200.0 * (y - z);
+}
 
-    free(xyz);
+SIMD_TARGET_CLONES
+static void convertLinearRGBBlockToLab(float *r, float *g, float *b, int n, float *l, float *a, float *bb)
+{
+    float lab_func[3][COLOR_BLOCK_SIZE];
 
-    return lab;
-}
\ No newline at end of file
+    // A loop per XYZ channel, which are vectorized, unlike a single one
+    for(int j = 0; j < 3; j++)
+    {
+        for(int i = 0; i < n; i++)
+        {
+            float xyz;
+
+            xyz = r[i] * SRGB_TO_XYZ[j][0] + g[i] * SRGB_TO_XYZ[j][1] + b[i] * SRGB_TO_XYZ[j][2];
+
+            lab_func[j][i] = labFunc(xyz/D65_WHITE[j]);
+        }
+    }
+
+    for(int i = 0; i < n; i++)
+    {
+        l[i] = (116.0 * lab_func[1][i]) - 16.0;
+        a[i] = 500.0 * (lab_func[0][i] - lab_func[1][i]);
+        bb[i] = 200.0 * (lab_func[1][i] - lab_func[2][i]);
+    }
+}
+
+void convertRowToLab(void *vals, PixelType type, int num_channels, int num_pixels, int normval, 
+                     const float *gamma_lut, float *lab, int pixel_stride, int feat_stride)
+{
+    bool is_gray;
+    float lin[3][COLOR_BLOCK_SIZE], out[3][COLOR_BLOCK_SIZE];
+
+    is_gray = num_channels <= 2; // Grayscale w/ w/o alpha
+
+    for(int first = 0; first < num_pixels; first += COLOR_BLOCK_SIZE)
+    {
+        int n;
+
+        n = num_pixels - first < COLOR_BLOCK_SIZE ? num_pixels - first : COLOR_BLOCK_SIZE;
+
+        // Gamma correction, by the LUT if 8- or 16-bit (and within it, which int32 values may not be)
+        for(int i = 0; i < n; i++)
+        {
+            for(int j = 0; j < 3; j++)
+            {
+                size_t index;
+
+                index = (size_t)(first + i) * num_channels + (is_gray ? 0 : j);
+
+                if(type == FLOAT32_TYPE) // Clamped, as out-of-range values have no sRGB meaning
+                {
+                    float value;
+
+                    value = ((float*)vals)[index];
+                    lin[j][i] = gammaCorr(value < 0 ? 0 : (value > 1 ? 1 : value));
+                }
+                else
+                {
+                    int value;
+
+                    if(type == UINT8_TYPE) value = ((unsigned char*)vals)[index];
+                    else if(type == UINT16_TYPE) value = ((unsigned short*)vals)[index];
+                    else value = ((int*)vals)[index];
+
+                    if(gamma_lut != NULL && value >= 0 && value <= normval) lin[j][i] = gamma_lut[value];
+                    else lin[j][i] = gammaCorr(value * 1.0/(float)normval);
+                }
+            }
+        }
+
+        convertLinearRGBBlockToLab(lin[0], lin[1], lin[2], n, out[0], out[1], out[2]);
+
+        for(int i = 0; i < n; i++)
+        {
+            float *pixel_lab;
+
+            pixel_lab = &(lab[(size_t)(first + i) * pixel_stride]);
+
+            pixel_lab[0] = out[0][i];
+            pixel_lab[feat_stride] = out[1][i];
+            pixel_lab[2 * feat_stride] = out[2][i];
+        }
+    }
+}
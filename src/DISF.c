@@ -1,5 +1,189 @@
 #include "DISF.h"
 
+#include <omp.h>
+
+//=============================================================================
+// Private Structures & Prototypes
+//=============================================================================
+// Per-node state of the IFT, packed so that relaxing an adjacent node touches a single cache line
+typedef struct
+{
+    double cost; // Path cost, i.e., the priority within the IFT queues
+    int label; // Valid if within a queue (i.e., GRAY) or conquered (i.e., BLACK)
+    unsigned int stamp; // Of the workspace's queue
+} IFTNode;
+
+// Dispatches the IFT queue operations to the selected engine
+typedef struct
+{
+    QueueEngine engine;
+    PrioQueue *heap;
+    BucketQueue *bucket;
+    unsigned int *stamp, *generation; // Of the engine in use
+    int stamp_stride;
+    long num_pushes, num_pops, num_decreases; // Since its creation
+} IFTQueue;
+
+// Horizontal strips for the tile-parallel IFT
+typedef struct
+{
+    int num_tiles, num_cols; // Of the graph it was built for
+    int *row_begin; // Tile t spans the rows [row_begin[t], row_begin[t+1][
+    IFTQueue **queues; // Over the tile's nodes only
+    RegionAdj **tree_adj; // Of the tile's rows
+    IFTQueue *seam_queue; // Over all nodes
+    int *inval_nodes, *node_stack; // For the seam repair
+} TiledIFT;
+
+// Buffers of runDISFWithWorkspace. Per-node ones hold node_capacity elements, and 
+// per-seed ones seed_capacity. Both capacities only grow
+struct DISFWorkspace
+{
+    int node_capacity, seed_capacity, num_feats;
+    NodeAdj *adj_rel;
+    // Per node
+    IFTNode *nodes;
+    bool *is_seed;
+    int *inval_nodes, *next_in_tree; // Differential mode only
+    Image *label_img; // Reshaped to the graph at each call
+    IFTQueue *queue;
+    TiledIFT *tiles; // Built on demand
+    // Per seed (i.e., tree)
+    int num_seeds;
+    int *seeds, *kept_seeds; // Current and next seed sets
+    Tree *tree_pool;
+    float *tree_feats; // Sum and mean of every tree in the pool
+    Tree **trees; // Into the pool, or NULL if removed
+    int *tree_first, *label_map; // Differential mode only
+    bool *is_kept; // Differential mode only
+    double *tree_prio;
+    PrioQueue *prio_queue; // For the seed selection
+    RegionAdj *tree_adj;
+    // Temporal warm-start. Cells are square, with gridSampling's stride as side, thus 
+    // holding a single grid sample each
+    bool has_frame; // If the seeds and the cells' reference are of a previous frame
+    int frame_rows, frame_cols, frame_n_0;
+    int cell_size, num_cell_rows, num_cell_cols, cell_capacity;
+    float *ref_cell_feats, *cell_feats; // Mean features at the cell's last sampling, and current
+    bool *is_cell_changed;
+    // Anytime mode
+    double start_time; // Of the current call
+    bool has_reached_target; // Of the last call
+};
+
+// If has_node_stamps, the states are kept within the nodes, thus only a single such queue may
+// span each node. Otherwise, the queue has its own
+static IFTQueue *createIFTQueue(int size, IFTNode *nodes, bool has_node_stamps, DISFOptions *opts);
+static void freeIFTQueue(IFTQueue **queue);
+static bool isIFTQueueEmpty(IFTQueue *queue);
+static int popIFTQueue(IFTQueue *queue);
+static void insertIFTQueue(IFTQueue *queue, int index);
+static void decreaseIFTQueue(IFTQueue *queue, int index);
+static void resetIFTQueue(IFTQueue *queue); // O(1), thus its states are recognized lazily
+static ElemState getIFTQueueState(IFTQueue *queue, int index);
+static void setIFTQueueState(IFTQueue *queue, int index, ElemState state);
+static size_t getIFTQueueBytes(IFTQueue *queue);
+
+static void setDefaultDISFOptions(DISFOptions *opts);
+// Of a (possibly strided) buffer, as getNormValue
+static int getBufferNormValue(void *data, PixelType type, int num_rows, int num_cols, int num_channels,
+                              long row_stride, long pixel_stride, long channel_stride);
+// Strides are in bytes, and normval is the input's maximum possible value
+static Graph *createGraphOfStrides(void *data, PixelType type, int num_rows, int num_cols, int num_channels,
+                                   long row_stride, long pixel_stride, long channel_stride, int normval,
+                                   FeatLayout layout);
+// Grows the workspace, if needed, and rebuilds the queue if the engine differs
+static void reserveDISFWorkspace(DISFWorkspace *ws, int num_nodes, int num_seeds, int num_feats, DISFOptions *opts);
+static void reserveTiledIFT(DISFWorkspace *ws, Graph *graph, DISFOptions *opts);
+static void resetTree(Tree *tree, int root_index);
+static int getMaxNumGridSeeds(int num_rows, int num_cols, int num_seeds); // Upper bound for gridSampling
+static int getNumMaintainedTrees(DISFOptions *opts, int iter, int n_0, int n_f); // Of the removal schedule
+// Rejects the schedules whose number of maintained trees would not decrease (e.g., a rate <= 0)
+static void checkRemovalSchedule(DISFOptions *opts);
+// First iteration whose number of maintained trees is below num_seeds (or n_f), for resuming the schedule
+static int getScheduleIter(DISFOptions *opts, int n_0, int n_f, int num_seeds);
+static float getGridStride(int num_nodes, int num_seeds); // Of gridSampling
+
+static void computeGradientWeights(NodeAdj *adj_rel, float *dist_weight);
+static double computeNodeGradient(Graph *graph, NodeAdj *adj_rel, float *dist_weight, int index);
+static void computeGradientInto(Graph *graph, NodeAdj *adj_rel, double *grad);
+// Gradient of the nodes within the rows [row_begin, row_end[, but the first and last columns,
+// whose neighbors (within a 1-pixel radius) must be valid. Thus, there is no bounds checking.
+// Vectorized along the rows, by clones that do not contract into FMAs (see SIMD_TARGET_CLONES).
+// Thus, on any CPU, with the same values as computeNodeGradient, if it is not built for FMA either
+static void computeInteriorGradient(Graph *graph, NodeAdj *adj_rel, float *dist_weight, int row_begin, 
+                                    int row_end, double *grad);
+// Adds weight times the L1 distance between the Lab features of num_nodes consecutive nodes
+// and their adjacents' (i.e., adj_feats) to grad
+static void accumulateGradientRow(float *feats, float *adj_feats, int node_stride, int feat_stride, 
+                                  int num_nodes, float weight, double *grad);
+// Marks the grid samples in is_seed, and returns their quantity. If grad is not NULL, the whole
+// gradient is computed in it. Otherwise, it is only evaluated around each grid point
+static int markGridSeeds(Graph *graph, NodeAdj *adj_rel, int num_seeds, double *grad, bool *is_seed);
+// Node of minimum gradient among the one at coords and its adjacents. If grad is NULL, they are
+// evaluated by computeNodeGradient
+static int findMinGradientNode(Graph *graph, NodeAdj *adj_rel, float *dist_weight, double *grad, 
+                               NodeCoords coords);
+// Writes the roots of the (at most) num_maintain most relevant trees in rel_seeds, by increasing
+// relevance (i.e., as selectKMostRelevantSeeds' list), and returns their quantity. The first 
+// num_pinned trees are always kept, thus neither considered nor written. The queue must be 
+// empty and set over tree_prio
+static int selectKMostRelevantTrees(Tree **trees, RegionAdj *tree_adj, int num_nodes, int num_trees, 
+                                    int num_pinned, int num_maintain, double *tree_prio, PrioQueue *queue, 
+                                    int *rel_seeds);
+
+// Reserves the workspace for the graph, and reshapes its label image
+static void prepareDISFWorkspace(DISFWorkspace *ws, Graph *graph, DISFOptions *opts);
+// The seeds must be already sampled in the workspace. The removal schedule starts at first_iter
+// Pinned trees (NULL for none) take the first labels. Every forest is recorded in hierarchy, if
+// not NULL. Both are only supported in the non-differential modes
+static void runDISFFromSeeds(DISFWorkspace *ws, Graph *graph, int n_0, int n_f, Image **border_img, 
+                             DISFOptions *opts, int first_iter, PinnedTrees *pinned, DISFHierarchy *hierarchy);
+static void collectMarkedSeeds(DISFWorkspace *ws, Graph *graph); // From is_seed, which is cleared
+// Sums the operations of the workspace's IFT queues (i.e., pushes, pops and decreases)
+static void getIFTQueueCounts(DISFWorkspace *ws, long *counts);
+// Appends an iteration, whose queue operations are the differences between both counts
+static void recordDISFStatsIter(DISFStats *stats, int num_trees, double ift_time, double selection_time, 
+                                long *prev_counts, long *counts);
+static size_t getDISFWorkspaceBytes(DISFWorkspace *ws); // Of its buffers
+static size_t getRegionAdjBytes(RegionAdj *adj);
+// If another iteration fits within the anytime limits of opts (and progress agrees), after
+// num_iters iterations, the last of which took iter_time seconds and grew num_trees trees
+static bool continueDISFRun(DISFWorkspace *ws, DISFOptions *opts, int num_iters, int num_trees, double iter_time);
+static void runDifferentialDISF(DISFWorkspace *ws, Graph *graph, int n_0, int n_f, Image **border_img, 
+                                DISFOptions *opts, int first_iter);
+
+// Sets the graph as the reference of every cell for runDISFTemporal
+static void startTemporalFrame(DISFWorkspace *ws, Graph *graph, int n_0);
+
+static DISFHierarchy *createDISFHierarchy(Graph *graph, int num_seeds);
+// Appends the forest in nodes, whose trees' ids are in tree_ids (by label)
+static void recordDISFHierarchyLevel(DISFHierarchy *hierarchy, IFTNode *nodes, int *tree_ids, int num_trees);
+static void computeCellMeans(Graph *graph, int cell_size, int num_cell_rows, int num_cell_cols, float *cell_feats);
+// Keeps the previous seeds within unchanged cells, and re-samples the changed ones, whose reference
+// is updated. Returns the number of seeds
+static int resampleChangedCells(DISFWorkspace *ws, Graph *graph, int n_0, DISFOptions *opts);
+// Grows the forest from the nodes within the queue, restricted to the rows [row_begin, row_end[.
+// The queue is indexed relative to the first node of row_begin. The cost and label of WHITE nodes
+// are never read (i.e., their cost is INFINITY), thus need no initialization. If tree_adj is NULL,
+// it is not computed. If tree_first is not NULL, the conquered nodes are linked to their trees' lists
+static void growForest(Graph *graph, NodeAdj *adj_rel, IFTNode *nodes, IFTQueue *queue,
+                       int row_begin, int row_end, Tree **trees, RegionAdj *tree_adj, int *tree_first, 
+                       int *next_in_tree);
+static void computeBorderImage(Graph *graph, Image *label_img, NodeAdj *adj_rel, Image *border_img);
+// Offers each invalidated (i.e., WHITE) node the best path from its conquered (i.e., BLACK)
+// neighbors, and inserts it in the queue if any. The queue must span the whole image
+static void seedInvalidatedNodes(Graph *graph, NodeAdj *adj_rel, IFTNode *nodes, 
+                                 IFTQueue *queue, Tree **trees, int *inval_nodes, int num_inval);
+
+static TiledIFT *createTiledIFT(Graph *graph, IFTNode *nodes, int num_trees, DISFOptions *opts);
+static void freeTiledIFT(TiledIFT **tiles);
+// The seeds (i.e., the trees' roots) must be already initialized in nodes
+static void growTiledForest(Graph *graph, NodeAdj *adj_rel, IFTNode *nodes, TiledIFT *tiles,
+                            Tree **trees, int num_trees, RegionAdj *tree_adj, int seam_width);
+static void repairTileSeam(Graph *graph, NodeAdj *adj_rel, IFTNode *nodes, TiledIFT *tiles,
+                           Tree **trees, int num_trees, int seam_row, int seam_width);
+
 //=============================================================================
 // Constructors & Deconstructors
 //=============================================================================
@@ -48,32 +232,102 @@ NodeAdj *create8NeighAdj()
 }
 
 Graph *createGraph(Image *img)
+{
+    return createGraphWithLayout(img, INTERLEAVED_LAYOUT);
+}
+
+Graph *createGraphWithLayout(Image *img, FeatLayout layout)
+{
+    long type_size;
+
+    type_size = getPixelTypeSize(img->type);
+
+    return createGraphOfStrides(img->val.raw, img->type, img->num_rows, img->num_cols, img->num_channels,
+                                img->num_cols * img->num_channels * type_size, img->num_channels * type_size, 
+                                type_size, getNormValue(img), layout);
+}
+
+Graph *createGraphFromBuffer(void *data, PixelType type, int num_rows, int num_cols, int num_channels,
+                             long row_stride, long pixel_stride, long channel_stride)
 {
     int normval;
+
+    normval = getBufferNormValue(data, type, num_rows, num_cols, num_channels, row_stride, pixel_stride, 
+                                 channel_stride);
+
+    return createGraphOfStrides(data, type, num_rows, num_cols, num_channels, row_stride, pixel_stride, 
+                                channel_stride, normval, INTERLEAVED_LAYOUT);
+}
+
+static Graph *createGraphOfStrides(void *data, PixelType type, int num_rows, int num_cols, int num_channels,
+                                   long row_stride, long pixel_stride, long channel_stride, int normval,
+                                   FeatLayout layout)
+{
+    bool is_packed;
+    int pixel_stride_lab, feat_stride;
+    long type_size;
+    const float *gamma_lut;
     Graph *graph;
 
-    normval = getNormValue(img);
+    type_size = getPixelTypeSize(type);
+    gamma_lut = getsRGBGammaLUT(normval); // Once per graph, rather than per row
+    is_packed = pixel_stride == num_channels * type_size && channel_stride == type_size;
 
     graph = (Graph*)calloc(1, sizeof(Graph));
 
-    graph->num_cols = img->num_cols;
-    graph->num_rows = img->num_rows;
+    graph->num_cols = num_cols;
+    graph->num_rows = num_rows;
     graph->num_feats = 3; // L*a*b cspace
-    graph->num_nodes = img->num_pixels;
+    graph->num_nodes = num_rows * num_cols;
+    graph->layout = layout;
 
-    graph->feats = (float**)calloc(graph->num_nodes, sizeof(float*));
+    graph->feats = (float*)calloc(graph->num_nodes * graph->num_feats, sizeof(float));
 
-    #pragma omp parallel for
-    for(int i = 0; i < graph->num_nodes; i++)
+    if(layout == INTERLEAVED_LAYOUT) 
+    {
+        pixel_stride_lab = graph->num_feats;
+        feat_stride = 1;
+    }
+    else 
+    {
+        pixel_stride_lab = 1;
+        feat_stride = graph->num_nodes;
+    }
+
+    // A row at a time, by the batch conversion. Non-packed rows are gathered first
+    #pragma omp parallel
     {
-        if(img->num_channels <= 2) // Grayscale w/ w/o alpha
-            graph->feats[i] = convertGrayToLab(img->val[i], normval);
-        else// sRGB
-            graph->feats[i] = convertsRGBToLab(img->val[i], normval);
+        char *row_buf;
+
+        row_buf = is_packed ? NULL : (char*)malloc(num_cols * num_channels * type_size);
+
+        #pragma omp for
+        for(int y = 0; y < num_rows; y++)
+        {
+            char *row;
+
+            row = (char*)data + y * row_stride;
+
+            if(!is_packed)
+            {
+                for(int x = 0; x < num_cols; x++)
+                    for(int c = 0; c < num_channels; c++)
+                        memcpy(&(row_buf[(x * num_channels + c) * type_size]), 
+                               &(row[x * pixel_stride + c * channel_stride]), type_size);
+
+                row = row_buf;
+            }
+
+            convertRowToLab(row, type, num_channels, num_cols, normval, gamma_lut,
+                            &(graph->feats[(size_t)y * num_cols * pixel_stride_lab]), pixel_stride_lab, feat_stride);
+        }
+
+        free(row_buf);
     }
 
     return graph;
 }
+
 Tree *createTree(int root_index, int num_feats)
 {
     Tree *tree;
@@ -84,11 +338,140 @@ Tree *createTree(int root_index, int num_feats)
     tree->num_nodes = 0;
     tree->num_feats = num_feats;
 
-    tree->sum_feat = (float*)calloc(num_feats, sizeof(float));
+    // A single block for both
+    tree->sum_feat = (float*)calloc(2 * num_feats, sizeof(float));
+    tree->mean_feat = &(tree->sum_feat[num_feats]);
 
     return tree;
 }
 
+DISFOptions *createDISFOptions()
+{
+    DISFOptions *opts;
+
+    opts = (DISFOptions*)calloc(1, sizeof(DISFOptions));
+
+    setDefaultDISFOptions(opts);
+
+    return opts;
+}
+
+DISFStats *createDISFStats()
+{
+    DISFStats *stats;
+
+    stats = (DISFStats*)calloc(1, sizeof(DISFStats));
+
+    // Grown as needed
+    stats->iter_capacity = 16;
+    stats->num_trees = (int*)calloc(stats->iter_capacity, sizeof(int));
+    stats->ift_time = (double*)calloc(stats->iter_capacity, sizeof(double));
+    stats->selection_time = (double*)calloc(stats->iter_capacity, sizeof(double));
+    stats->num_pushes = (long*)calloc(stats->iter_capacity, sizeof(long));
+    stats->num_pops = (long*)calloc(stats->iter_capacity, sizeof(long));
+    stats->num_decreases = (long*)calloc(stats->iter_capacity, sizeof(long));
+
+    return stats;
+}
+
+DISFWorkspace *createDISFWorkspace(int max_num_rows, int max_num_cols, int max_n_0, DISFOptions *opts)
+{
+    DISFOptions default_opts;
+    DISFWorkspace *ws;
+
+    if(opts == NULL)
+    {
+        setDefaultDISFOptions(&default_opts);
+        opts = &default_opts;
+    }
+
+    ws = (DISFWorkspace*)calloc(1, sizeof(DISFWorkspace));
+
+    ws->adj_rel = create8NeighAdj();
+    ws->num_feats = 3; // L*a*b cspace
+
+    reserveDISFWorkspace(ws, max_num_rows * max_num_cols, getMaxNumGridSeeds(max_num_rows, max_num_cols, max_n_0), 
+                         ws->num_feats, opts);
+
+    return ws;
+}
+
+static IFTQueue *createIFTQueue(int size, IFTNode *nodes, bool has_node_stamps, DISFOptions *opts)
+{
+    int prio_stride, stamp_stride;
+    unsigned int *stamp;
+    IFTQueue *queue;
+
+    queue = (IFTQueue*)calloc(1, sizeof(IFTQueue));
+
+    queue->engine = opts->queue_engine;
+
+    // The costs are always within the nodes
+    prio_stride = sizeof(IFTNode) / sizeof(double);
+
+    if(has_node_stamps)
+    {
+        stamp = &(nodes[0].stamp);
+        stamp_stride = sizeof(IFTNode) / sizeof(unsigned int);
+    }
+    else
+    {
+        stamp = NULL;
+        stamp_stride = 1;
+    }
+
+    if(queue->engine == BUCKET_QUEUE)
+    {
+        queue->bucket = createBucketQueueOfRecords(size, &(nodes[0].cost), prio_stride, stamp, stamp_stride, 
+                                                   MAX_LAB_DIST, opts->bucket_step);
+        queue->stamp = queue->bucket->stamp;
+        queue->generation = &(queue->bucket->generation);
+    }
+    else
+    {
+        queue->heap = createPrioQueueOfRecords(size, &(nodes[0].cost), prio_stride, stamp, stamp_stride, 
+                                               MINVAL_POLICY);
+        queue->stamp = queue->heap->stamp;
+        queue->generation = &(queue->heap->generation);
+    }
+    queue->stamp_stride = stamp_stride;
+
+    return queue;
+}
+
+static TiledIFT *createTiledIFT(Graph *graph, IFTNode *nodes, int num_trees, DISFOptions *opts)
+{
+    TiledIFT *tiles;
+
+    tiles = (TiledIFT*)calloc(1, sizeof(TiledIFT));
+
+    tiles->num_tiles = MIN(opts->num_tiles, graph->num_rows);
+    tiles->num_cols = graph->num_cols;
+    tiles->row_begin = (int*)calloc(tiles->num_tiles + 1, sizeof(int));
+    tiles->queues = (IFTQueue**)calloc(tiles->num_tiles, sizeof(IFTQueue*));
+    tiles->tree_adj = (RegionAdj**)calloc(tiles->num_tiles, sizeof(RegionAdj*));
+
+    for(int i = 0; i <= tiles->num_tiles; i++)
+        tiles->row_begin[i] = (int)((long)i * graph->num_rows / tiles->num_tiles);
+
+    for(int i = 0; i < tiles->num_tiles; i++)
+    {
+        int offset, num_tile_nodes;
+
+        offset = tiles->row_begin[i] * graph->num_cols;
+        num_tile_nodes = (tiles->row_begin[i + 1] - tiles->row_begin[i]) * graph->num_cols;
+
+        tiles->queues[i] = createIFTQueue(num_tile_nodes, &(nodes[offset]), false, opts);
+        tiles->tree_adj[i] = createRegionAdj(num_trees);
+    }
+
+    tiles->seam_queue = createIFTQueue(graph->num_nodes, nodes, false, opts);
+    tiles->inval_nodes = (int*)calloc(graph->num_nodes, sizeof(int));
+    tiles->node_stack = (int*)calloc(graph->num_nodes, sizeof(int));
+
+    return tiles;
+}
+
 void freeNodeAdj(NodeAdj **adj_rel)
 {
     if(*adj_rel != NULL)
@@ -112,8 +495,6 @@ void freeGraph(Graph **graph)
 
         tmp = *graph;
 
-        for(int i = 0; i < tmp->num_nodes; i++)
-            free(tmp->feats[i]);
         free(tmp->feats);
         free(tmp);
 
@@ -121,6 +502,165 @@ void freeGraph(Graph **graph)
     }
 }
 
+void freeDISFOptions(DISFOptions **opts)
+{
+    if(*opts != NULL)
+    {
+        free(*opts);
+        *opts = NULL;
+    }
+}
+
+static DISFHierarchy *createDISFHierarchy(Graph *graph, int num_seeds)
+{
+    DISFHierarchy *hierarchy;
+
+    hierarchy = (DISFHierarchy*)calloc(1, sizeof(DISFHierarchy));
+
+    hierarchy->num_rows = graph->num_rows;
+    hierarchy->num_cols = graph->num_cols;
+    hierarchy->num_nodes = graph->num_nodes;
+
+    // Grown as needed
+    hierarchy->num_levels = 0;
+    hierarchy->level_capacity = 8;
+    hierarchy->num_superpixels = (int*)calloc(hierarchy->level_capacity, sizeof(int));
+    hierarchy->seed_start = (int*)calloc(hierarchy->level_capacity + 1, sizeof(int));
+    hierarchy->delta_start = (int*)calloc(hierarchy->level_capacity + 1, sizeof(int));
+
+    hierarchy->seed_capacity = 2 * num_seeds;
+    hierarchy->seed_ids = (int*)calloc(hierarchy->seed_capacity, sizeof(int));
+
+    hierarchy->delta_capacity = graph->num_nodes / 4;
+    hierarchy->delta_nodes = (int*)calloc(hierarchy->delta_capacity, sizeof(int));
+    hierarchy->delta_ids = (int*)calloc(hierarchy->delta_capacity, sizeof(int));
+
+    hierarchy->base_ids = (int*)calloc(graph->num_nodes, sizeof(int));
+    hierarchy->curr_ids = (int*)calloc(graph->num_nodes, sizeof(int));
+
+    return hierarchy;
+}
+
+void freeDISFStats(DISFStats **stats)
+{
+    if(*stats != NULL)
+    {
+        DISFStats *tmp;
+
+        tmp = *stats;
+
+        free(tmp->num_trees);
+        free(tmp->ift_time);
+        free(tmp->selection_time);
+        free(tmp->num_pushes);
+        free(tmp->num_pops);
+        free(tmp->num_decreases);
+        free(tmp);
+
+        *stats = NULL;
+    }
+}
+
+void freeDISFHierarchy(DISFHierarchy **hierarchy)
+{
+    if(*hierarchy != NULL)
+    {
+        DISFHierarchy *tmp;
+
+        tmp = *hierarchy;
+
+        free(tmp->num_superpixels);
+        free(tmp->base_ids);
+        free(tmp->seed_start);
+        free(tmp->seed_ids);
+        free(tmp->delta_start);
+        free(tmp->delta_nodes);
+        free(tmp->delta_ids);
+        free(tmp->curr_ids);
+        free(tmp);
+
+        *hierarchy = NULL;
+    }
+}
+
+void freeDISFWorkspace(DISFWorkspace **ws)
+{
+    if(*ws != NULL)
+    {
+        DISFWorkspace *tmp;
+
+        tmp = *ws;
+
+        freeNodeAdj(&(tmp->adj_rel));
+        free(tmp->nodes);
+        free(tmp->is_seed);
+        free(tmp->inval_nodes);
+        free(tmp->next_in_tree);
+        freeImage(&(tmp->label_img));
+        freeIFTQueue(&(tmp->queue));
+        freeTiledIFT(&(tmp->tiles));
+        free(tmp->seeds);
+        free(tmp->kept_seeds);
+        free(tmp->tree_pool);
+        free(tmp->tree_feats);
+        free(tmp->trees);
+        free(tmp->tree_first);
+        free(tmp->label_map);
+        free(tmp->is_kept);
+        free(tmp->tree_prio);
+        freePrioQueue(&(tmp->prio_queue));
+        freeRegionAdj(&(tmp->tree_adj));
+        free(tmp->ref_cell_feats);
+        free(tmp->cell_feats);
+        free(tmp->is_cell_changed);
+        free(tmp);
+
+        *ws = NULL;
+    }
+}
+
+static void freeIFTQueue(IFTQueue **queue)
+{
+    if(*queue != NULL)
+    {
+        IFTQueue *tmp;
+
+        tmp = *queue;
+
+        if(tmp->heap != NULL) freePrioQueue(&(tmp->heap));
+        if(tmp->bucket != NULL) freeBucketQueue(&(tmp->bucket));
+        free(tmp);
+
+        *queue = NULL;
+    }
+}
+
+static void freeTiledIFT(TiledIFT **tiles)
+{
+    if(*tiles != NULL)
+    {
+        TiledIFT *tmp;
+
+        tmp = *tiles;
+
+        for(int i = 0; i < tmp->num_tiles; i++)
+        {
+            freeIFTQueue(&(tmp->queues[i]));
+            freeRegionAdj(&(tmp->tree_adj[i]));
+        }
+
+        free(tmp->row_begin);
+        free(tmp->queues);
+        free(tmp->tree_adj);
+        freeIFTQueue(&(tmp->seam_queue));
+        free(tmp->inval_nodes);
+        free(tmp->node_stack);
+        free(tmp);
+
+        *tiles = NULL;
+    }
+}
+
 void freeTree(Tree **tree)
 {
     if(*tree != NULL)
@@ -145,6 +685,32 @@ inline bool areValidNodeCoords(Graph *graph, NodeCoords coords)
             (coords.y >= 0 && coords.y < graph->num_rows);
 }
 
+bool hasDISFReachedTarget(DISFWorkspace *ws)
+{
+    return ws->has_reached_target;
+}
+
+static bool continueDISFRun(DISFWorkspace *ws, DISFOptions *opts, int num_iters, int num_trees, double iter_time)
+{
+    bool go_on;
+    double elapsed;
+
+    elapsed = omp_get_wtime() - ws->start_time;
+
+    go_on = opts->progress == NULL || opts->progress(num_iters, num_trees, elapsed, opts->progress_data);
+
+    if(opts->max_iters > 0 && num_iters >= opts->max_iters) go_on = false;
+    else if(opts->time_budget > 0 && elapsed + iter_time > opts->time_budget) go_on = false;
+
+    return go_on;
+}
+
+static inline bool isIFTQueueEmpty(IFTQueue *queue)
+{
+    if(queue->engine == BUCKET_QUEUE) return isBucketQueueEmpty(queue->bucket);
+    else return isPrioQueueEmpty(queue->heap);
+}
+
 //=============================================================================
 // Int
 //=============================================================================
@@ -153,445 +719,2001 @@ inline int getNodeIndex(Graph *graph, NodeCoords coords)
     return coords.y * graph->num_cols + coords.x;
 }
 
-//=============================================================================
-// Double
-//=============================================================================
-inline double euclDistance(float *feat1, float *feat2, int num_feats)
+int getDISFHierarchyLevel(DISFHierarchy *hierarchy, int num_superpixels)
 {
-    double dist;
+    int level;
 
-    dist = 0;
+    // Levels are by decreasing quantity
+    level = 0;
+    while(level < hierarchy->num_levels - 1 && hierarchy->num_superpixels[level + 1] >= num_superpixels)
+        level++;
 
-    for(int i = 0; i < num_feats; i++)
-        dist += (feat1[i] - feat2[i]) * (feat1[i] - feat2[i]);
-    dist = sqrtf(dist);
+    return level;
+}
 
-    return dist;
+static inline int popIFTQueue(IFTQueue *queue)
+{
+    queue->num_pops++;
+
+    if(queue->engine == BUCKET_QUEUE) return popBucketQueue(&(queue->bucket));
+    else return popPrioQueue(&(queue->heap));
 }
 
-inline double taxicabDistance(float *feat1, float *feat2, int num_feats)
+static int getBufferNormValue(void *data, PixelType type, int num_rows, int num_cols, int num_channels,
+                              long row_stride, long pixel_stride, long channel_stride)
 {
-    double dist;
+    int max_val;
 
-    dist = 0;
+    if(type == UINT8_TYPE) return 255; // No need to scan
+    if(type == FLOAT32_TYPE) return 1; // Already normalized
 
-    for(int i = 0; i < num_feats; i++)
-        dist += fabs(feat1[i] - feat2[i]);
+    max_val = 0;
 
-    return dist;
-}
+    #pragma omp parallel for reduction(max:max_val)
+    for(int y = 0; y < num_rows; y++)
+        for(int x = 0; x < num_cols; x++)
+            for(int c = 0; c < num_channels; c++)
+            {
+                char *val;
 
-//=============================================================================
-// NodeCoords
-//=============================================================================
-inline NodeCoords getAdjacentNodeCoords(NodeAdj *adj_rel, NodeCoords coords, int id)
-{
-    NodeCoords adj_coords;
+                val = (char*)data + y * row_stride + x * pixel_stride + c * channel_stride;
 
-    adj_coords.x = coords.x + adj_rel->dx[id];
-    adj_coords.y = coords.y + adj_rel->dy[id];
+                if(type == UINT16_TYPE) max_val = MAX(max_val, *(unsigned short*)val);
+                else max_val = MAX(max_val, *(int*)val);
+            }
 
-    return adj_coords;
-}
+    if(max_val > 65535)
+        printError("getBufferNormValue", "This code supports only 8-bit and 16-bit images!");
 
+    if(max_val <= 255) return 255;
+    else return 65535;
+}
 
-inline NodeCoords getNodeCoords(Graph *graph, int index)
+static int getMaxNumGridSeeds(int num_rows, int num_cols, int num_seeds)
 {
-    NodeCoords coords;
+    int step;
 
-    coords.x = index % graph->num_cols;
-    coords.y = index / graph->num_cols;
+    // Integer coordinates advance by the stride's floor
+    step = MAX((int)getGridStride(num_rows * num_cols, num_seeds), 1);
 
-    return coords;
+    return (num_rows / step + 1) * (num_cols / step + 1);
 }
 
-//=============================================================================
-// Float*
-//=============================================================================
-inline float* meanTreeFeatVector(Tree *tree)
+static int getNumMaintainedTrees(DISFOptions *opts, int iter, int n_0, int n_f)
 {
-    float* mean_feat;
-
-    mean_feat = (float*)calloc(tree->num_feats, sizeof(float));
+    double num_maintain;
 
-    for(int i = 0; i < tree->num_feats; i++)
-        mean_feat[i] = tree->sum_feat[i]/(float)tree->num_nodes;
+    switch(opts->schedule)
+    {
+        case GEOMETRIC_SCHEDULE:
+            num_maintain = n_0 * pow(n_f / (double)n_0, iter / (double)opts->num_stages);
+            break;
+        case LINEAR_SCHEDULE:
+            num_maintain = n_0 - iter * (n_0 - n_f) / (double)opts->num_stages;
+            break;
+        case CUSTOM_SCHEDULE:
+            num_maintain = opts->schedule_func(iter, n_0, n_f, opts->schedule_data);
+            break;
+        default:
+            num_maintain = n_0 * exp(-opts->schedule_rate * iter);
+    }
 
-    return mean_feat;
+    return MAX(num_maintain, n_f);
 }
 
-//=============================================================================
-// Double*
-//=============================================================================
-double *computeGradient(Graph *graph)
+static int getScheduleIter(DISFOptions *opts, int n_0, int n_f, int num_seeds)
 {
-    float max_adj_dist, sum_weight;
-    float *dist_weight;
-    double *grad;
-    NodeAdj *adj_rel;
+    int iter, num_maintain;
 
-    grad = (double*)calloc(graph->num_nodes, sizeof(double));
-    adj_rel = create8NeighAdj();
+    iter = 1;
+    num_maintain = getNumMaintainedTrees(opts, iter, n_0, n_f);
 
-    max_adj_dist = sqrtf(2); // Diagonal distance for 8-neighborhood
-    dist_weight = (float*)calloc(adj_rel->size, sizeof(float));
-    sum_weight = 0;
-    
-    // Closer --> higher weight
-    for(int i = 0; i < adj_rel->size; i++)
+    while(num_maintain >= num_seeds && num_maintain > n_f && iter < n_0)
     {
-        float div;
-
-        div = sqrtf(adj_rel->dx[i] * adj_rel->dx[i] + adj_rel->dy[i] * adj_rel->dy[i]);
-        
-        dist_weight[i] = max_adj_dist / div;
-        sum_weight += dist_weight[i];
+        iter++;
+        num_maintain = getNumMaintainedTrees(opts, iter, n_0, n_f);
     }
 
-    for(int i = 0; i < adj_rel->size; i++)
-        dist_weight[i] /= sum_weight;
+    return iter;
+}
 
-    #pragma omp parallel for
-    for(int i = 0; i < graph->num_nodes; i++)
-    {
-        float *feats;
-        NodeCoords coords;
+static int markGridSeeds(Graph *graph, NodeAdj *adj_rel, int num_seeds, double *grad, bool *is_seed)
+{
+    int num_marked;
+    float stride, delta_x, delta_y;
+    float dist_weight[adj_rel->size];
 
-        feats = graph->feats[i];
-        coords = getNodeCoords(graph, i);
+    stride = getGridStride(graph->num_nodes, num_seeds);
 
-        for(int j = 0; j < adj_rel->size; j++)
-        {
-            float *adj_feats;
-            NodeCoords adj_coords;
+    delta_x = delta_y = stride/2.0;
 
-            adj_coords = getAdjacentNodeCoords(adj_rel, coords, j);
+    if(delta_x < 1.0 || delta_y < 1.0)
+        printError("gridSampling", "The number of samples is too high");
 
-            if(areValidNodeCoords(graph, adj_coords))
-            {
-                int adj_index;
-                double dist;
+    if(grad != NULL) computeGradientInto(graph, adj_rel, grad);
+    else computeGradientWeights(adj_rel, dist_weight);
 
-                adj_index = getNodeIndex(graph, adj_coords);
+    memset(is_seed, 0, graph->num_nodes * sizeof(bool));
+    num_marked = 0;
+
+    for(int y = (int)delta_y; y < graph->num_rows; y += stride)
+    {
+        for(int x = (int)delta_x; x < graph->num_cols; x += stride)
+        {
+            int min_grad_index;
+            NodeCoords curr_coords;
 
-                adj_feats = graph->feats[adj_index];
+            curr_coords.x = x;
+            curr_coords.y = y;
 
-                dist = taxicabDistance(adj_feats, feats, graph->num_feats);
+            min_grad_index = findMinGradientNode(graph, adj_rel, dist_weight, grad, curr_coords);
 
-                grad[i] += dist * dist_weight[j];
-            }            
+            if(!is_seed[min_grad_index]) // Assuring unique values
+            {
+                is_seed[min_grad_index] = true;
+                num_marked++;
+            }
         }
     }
 
-    free(dist_weight);
-    freeNodeAdj(&adj_rel);
-
-    return grad;
+    return num_marked;
 }
 
-//=============================================================================
-// Image*
-//=============================================================================
-Image *runDISF(Graph *graph, int n_0, int n_f, Image **border_img)
+static int findMinGradientNode(Graph *graph, NodeAdj *adj_rel, float *dist_weight, double *grad, 
+                               NodeCoords coords)
 {
-    bool want_borders;
-    int num_rem_seeds, iter;
-    double *cost_map;
-    NodeAdj *adj_rel;
-    IntList *seed_set;
-    Image *label_img;
-    PrioQueue *queue;
-
-    // Aux
-    cost_map = (double*)calloc(graph->num_nodes, sizeof(double));
-    // adj_rel = create4NeighAdj();
-    adj_rel = create8NeighAdj();
-    label_img = createImage(graph->num_rows, graph->num_cols, 1);
-    queue = createPrioQueue(graph->num_nodes, cost_map, MINVAL_POLICY);
+    int min_grad_index;
+    double min_grad;
 
-    want_borders = border_img != NULL;
+    min_grad_index = getNodeIndex(graph, coords);
 
-    seed_set = gridSampling(graph, n_0);
+    if(grad != NULL) min_grad = grad[min_grad_index];
+    else min_grad = computeNodeGradient(graph, adj_rel, dist_weight, min_grad_index);
 
-    iter = 1; // At least a single iteration is performed
-    do
+    for(int i = 0; i < adj_rel->size; i++)
     {
-        int seed_label, num_trees, num_maintain;
-        Tree **trees;
-        IntList **tree_adj;
-        bool **are_trees_adj;
+        NodeCoords adj_coords;
 
-        trees = (Tree**)calloc(seed_set->size, sizeof(Tree*));
-        tree_adj = (IntList**)calloc(seed_set->size, sizeof(IntList*));
-        are_trees_adj = (bool**)calloc(seed_set->size, sizeof(bool*));
+        adj_coords = getAdjacentNodeCoords(adj_rel, coords, i);
 
-        // Initialize values
-        #pragma omp parallel for
-        for(int i = 0; i < graph->num_nodes; i++)
+        if(areValidNodeCoords(graph, adj_coords))
         {
-            cost_map[i] = INFINITY;
-            label_img->val[i][0] = -1;
+            int adj_index;
+            double adj_grad;
+
+            adj_index = getNodeIndex(graph, adj_coords);
 
-            if(want_borders)
-                (*border_img)->val[i][0] = 0;
+            if(grad != NULL) adj_grad = grad[adj_index];
+            else adj_grad = computeNodeGradient(graph, adj_rel, dist_weight, adj_index);
+
+            if(adj_grad < min_grad)
+            {
+                min_grad_index = adj_index;
+                min_grad = adj_grad;
+            }
         }
+    }
 
-        seed_label = 0;
-        for(IntCell *ptr = seed_set->head; ptr != NULL; ptr = ptr->next)
-        {   
-            int seed_index;
+    return min_grad_index;
+}
+
+static int resampleChangedCells(DISFWorkspace *ws, Graph *graph, int n_0, DISFOptions *opts)
+{
+    int num_prev, num_seeds, num_changed, num_cells;
+    int *prev_seeds;
+    float stride, dist_weight[ws->adj_rel->size];
+
+    num_cells = ws->num_cell_rows * ws->num_cell_cols;
+    computeCellMeans(graph, ws->cell_size, ws->num_cell_rows, ws->num_cell_cols, ws->cell_feats);
+
+    num_changed = 0;
+    for(int i = 0; i < num_cells; i++)
+    {
+        float *ref_feats, *feats;
+
+        ref_feats = &(ws->ref_cell_feats[i * graph->num_feats]);
+        feats = &(ws->cell_feats[i * graph->num_feats]);
+
+        ws->is_cell_changed[i] = euclDistance(ref_feats, feats, graph->num_feats) > opts->change_threshold;
 
-            seed_index = ptr->elem;
+        if(ws->is_cell_changed[i])
+        {
+            for(int j = 0; j < graph->num_feats; j++)
+                ref_feats[j] = feats[j];
+            num_changed++;
+        }
+    }
+
+    // The previous seeds are set aside, since the seed arrays may be re-allocated
+    num_prev = ws->num_seeds;
+    prev_seeds = ws->inval_nodes;
+    memcpy(prev_seeds, ws->seeds, num_prev * sizeof(int));
 
-            cost_map[seed_index] = 0;
-            label_img->val[seed_index][0] = seed_label;
+    reserveDISFWorkspace(ws, graph->num_nodes, num_prev + num_changed, graph->num_feats, opts);
 
-            trees[seed_label] = createTree(seed_index, graph->num_feats);
-            tree_adj[seed_label] = createIntList();
-            are_trees_adj[seed_label] = (bool*)calloc(seed_set->size, sizeof(bool));
+    num_seeds = 0;
+    for(int i = 0; i < num_prev; i++)
+    {
+        int cell;
+        NodeCoords coords;
 
-            seed_label++;
-            insertPrioQueue(&queue, seed_index);
+        coords = getNodeCoords(graph, prev_seeds[i]);
+        cell = (coords.y / ws->cell_size) * ws->num_cell_cols + coords.x / ws->cell_size;
+
+        if(!ws->is_cell_changed[cell])
+        {
+            ws->seeds[num_seeds++] = prev_seeds[i];
+            ws->is_seed[prev_seeds[i]] = true;
         }
+    }
+
+    // As in gridSampling, but only for the samples within the changed cells
+    stride = getGridStride(graph->num_nodes, n_0);
+    computeGradientWeights(ws->adj_rel, dist_weight);
 
-        // IFT algorithm
-        while(!isPrioQueueEmpty(queue))
+    for(int y = (int)(stride/2.0); y < graph->num_rows && num_changed > 0; y += stride)
+    {
+        for(int x = (int)(stride/2.0); x < graph->num_cols; x += stride)
         {
-            int node_index, node_label;
-            NodeCoords node_coords;
-            float *mean_feat_tree;
+            int min_grad_index;
+            NodeCoords curr_coords;
 
-            node_index = popPrioQueue(&queue);
-            node_coords = getNodeCoords(graph, node_index);
-            node_label = label_img->val[node_index][0];
+            if(!ws->is_cell_changed[(y / ws->cell_size) * ws->num_cell_cols + x / ws->cell_size]) continue;
 
-            // This node won't appear here ever again
-            insertNodeInTree(graph, node_index, &(trees[node_label]));
+            curr_coords.x = x;
+            curr_coords.y = y;
 
-            mean_feat_tree = meanTreeFeatVector(trees[node_label]);
+            min_grad_index = findMinGradientNode(graph, ws->adj_rel, dist_weight, NULL, curr_coords);
 
-            for(int i = 0; i < adj_rel->size; i++)
+            if(!ws->is_seed[min_grad_index]) // Assuring unique values
             {
-                NodeCoords adj_coords;
+                ws->seeds[num_seeds++] = min_grad_index;
+                ws->is_seed[min_grad_index] = true;
+            }
+        }
+    }
 
-                adj_coords = getAdjacentNodeCoords(adj_rel, node_coords, i);
+    for(int i = 0; i < num_seeds; i++)
+        ws->is_seed[ws->seeds[i]] = false;
 
-                if(areValidNodeCoords(graph, adj_coords))
-                {
-                    int adj_index, adj_label;
+    ws->num_seeds = num_seeds;
 
-                    adj_index = getNodeIndex(graph, adj_coords);
-                    adj_label = label_img->val[adj_index][0];
+    return num_seeds;
+}
 
-                    // If it wasn't inserted nor orderly removed from the queue
-                    if(queue->state[adj_index] != BLACK_STATE)
-                    {
-                        double arc_cost, path_cost;
+static int selectKMostRelevantTrees(Tree **trees, RegionAdj *tree_adj, int num_nodes, int num_trees, 
+                                    int num_pinned, int num_maintain, double *tree_prio, PrioQueue *queue, 
+                                    int *rel_seeds)
+{
+    int num_rel, num_alive;
 
-                        arc_cost = euclDistance(mean_feat_tree, graph->feats[adj_index], graph->num_feats);
+    buildRegionAdjLists(&tree_adj);
+    num_alive = 0;
 
-                        path_cost = MAX(cost_map[node_index], arc_cost);
+    for(int i = num_pinned; i < num_trees; i++)
+    {
+        double area_prio, grad_prio;
+        float *mean_feat_i;
 
-                        if(path_cost < cost_map[adj_index])
-                        {
-                            cost_map[adj_index] = path_cost;
-                            label_img->val[adj_index][0] = node_label;
+        if(trees[i] == NULL) continue; // Removed in a previous iteration
 
-                            if(queue->state[adj_index] == GRAY_STATE) moveIndexUpPrioQueue(&queue, adj_index);
-                            else insertPrioQueue(&queue, adj_index);
-                        }
-                    }
-                    else if(node_label != adj_label) // Their trees are adjacent
-                    {
-                        if(want_borders) // Both depicts a border between their superpixels
-                        {
-                            (*border_img)->val[node_index][0] = 255;
-                            (*border_img)->val[adj_index][0] = 255;
-                        }
+        area_prio = trees[i]->num_nodes/(float)num_nodes;
 
-                        if(!are_trees_adj[node_label][adj_label])
-                        {
-                            insertIntListTail(&(tree_adj[node_label]), adj_label);
-                            insertIntListTail(&(tree_adj[adj_label]), node_label);
-                            are_trees_adj[adj_label][node_label] = true;
-                            are_trees_adj[node_label][adj_label] = true;
-                        }
-                    }
-                }
-            }
+        grad_prio = INFINITY;
+        mean_feat_i = trees[i]->mean_feat;
+
+        for(int j = tree_adj->adj_start[i]; j < tree_adj->adj_start[i + 1]; j++)
+        {
+            int adj_tree_id;
+            float *mean_feat_j;
+            double dist;
 
-            free(mean_feat_tree);
+            adj_tree_id = tree_adj->adj_elems[j];
+            mean_feat_j = trees[adj_tree_id]->mean_feat;
+
+            dist = euclDistance(mean_feat_i, mean_feat_j, trees[i]->num_feats);
+
+            grad_prio = MIN(grad_prio, dist);
         }
 
-        num_maintain = MAX(n_0 * exp(-iter), n_f);
+        tree_prio[i] = area_prio * grad_prio;
 
-        // Aux
-        num_trees = seed_set->size;
-        freeIntList(&seed_set);
+        insertPrioQueue(&queue, i);
+        num_alive++;
+    }
 
-        seed_set = selectKMostRelevantSeeds(trees, tree_adj, graph->num_nodes, num_trees, num_maintain);
+    num_rel = MIN(num_maintain, num_alive);
+    for(int i = num_rel - 1; i >= 0; i--)
+    {
+        int tree_id;
 
-        num_rem_seeds = num_trees - seed_set->size;
-        
-        iter++;
-        resetPrioQueue(&queue);
+        tree_id = popPrioQueue(&queue);
 
-        for(int i = 0; i < num_trees; ++i)
-        {
-            freeTree(&(trees[i]));
-            freeIntList(&(tree_adj[i]));
-            free(are_trees_adj[i]);
-        }
-        free(trees);
-        free(tree_adj);
-        free(are_trees_adj);
-    } while(num_rem_seeds > 0);
+        rel_seeds[i] = trees[tree_id]->root_index;
+    }
 
-    free(cost_map);
-    freeNodeAdj(&adj_rel);
-    freeIntList(&seed_set);
-    freePrioQueue(&queue);
+    resetPrioQueue(&queue); // The remaining are discarded
 
-    return label_img;
+    return num_rel;
 }
 
 //=============================================================================
-// IntList*
+// Float
 //=============================================================================
-IntList *gridSampling(Graph *graph, int num_seeds)
+inline float getNodeFeat(Graph *graph, int index, int feat)
 {
-    float size, stride, delta_x, delta_y;
-    double *grad;
-    bool *is_seed;
-    IntList *seed_set;
-    NodeAdj *adj_rel;
+    if(graph->layout == INTERLEAVED_LAYOUT)
+        return graph->feats[index * graph->num_feats + feat];
+    else
+        return graph->feats[feat * graph->num_nodes + index];
+}
 
-    seed_set = createIntList();
-    is_seed = (bool*)calloc(graph->num_nodes, sizeof(bool));
+static inline float getGridStride(int num_nodes, int num_seeds)
+{
+    float size;
 
     // Approximate superpixel size
-    size = 0.5 + (float)(graph->num_nodes/(float)num_seeds);
-    stride = sqrtf(size) + 0.5;
+    size = 0.5 + (float)(num_nodes/(float)num_seeds);
 
-    delta_x = delta_y = stride/2.0;
+    return sqrtf(size) + 0.5;
+}
 
-    if(delta_x < 1.0 || delta_y < 1.0)
-        printError("gridSampling", "The number of samples is too high");
+//=============================================================================
+// Double
+//=============================================================================
+inline double euclDistance(float *feat1, float *feat2, int num_feats)
+{
+    double dist;
 
-    grad = computeGradient(graph);
-    adj_rel = create8NeighAdj();
+    dist = 0;
 
-    for(int y = (int)delta_y; y < graph->num_rows; y += stride)
-    {
-        for(int x = (int)delta_x; x < graph->num_cols; x += stride)
-        {
-            int min_grad_index;
-            NodeCoords curr_coords;
+    for(int i = 0; i < num_feats; i++)
+        dist += (feat1[i] - feat2[i]) * (feat1[i] - feat2[i]);
+    dist = sqrtf(dist);
 
-            curr_coords.x = x;
-            curr_coords.y = y;
+    return dist;
+}
 
-            min_grad_index = getNodeIndex(graph, curr_coords);
+static inline double computeNodeGradient(Graph *graph, NodeAdj *adj_rel, float *dist_weight, int index)
+{
+    float feats_buf[graph->num_feats], adj_feats_buf[graph->num_feats];
+    float *feats;
+    double grad;
+    NodeCoords coords;
 
-            for(int i = 0; i < adj_rel->size; i++)
-            {
-                NodeCoords adj_coords;
+    feats = getNodeFeats(graph, index, feats_buf);
+    coords = getNodeCoords(graph, index);
+    grad = 0;
 
-                adj_coords = getAdjacentNodeCoords(adj_rel, curr_coords, i);
+    for(int j = 0; j < adj_rel->size; j++)
+    {
+        NodeCoords adj_coords;
 
-                if(areValidNodeCoords(graph, adj_coords))
-                {
-                    int adj_index;
+        adj_coords = getAdjacentNodeCoords(adj_rel, coords, j);
 
-                    adj_index = getNodeIndex(graph, adj_coords);
+        if(areValidNodeCoords(graph, adj_coords))
+        {
+            float *adj_feats;
+            double dist;
 
-                    if(grad[adj_index] < grad[min_grad_index])
-                        min_grad_index = adj_index;
-                }
-            }
+            adj_feats = getNodeFeats(graph, getNodeIndex(graph, adj_coords), adj_feats_buf);
 
-            is_seed[min_grad_index] = true;
-        }
+            dist = taxicabDistance(adj_feats, feats, graph->num_feats);
+
+            grad += dist * dist_weight[j];
+        }            
     }
 
-    for(int i = 0; i < graph->num_nodes; i++)
-        if(is_seed[i]) // Assuring unique values
-            insertIntListTail(&seed_set, i);
+    return grad;
+}
 
-    free(grad);
-    free(is_seed);
-    freeNodeAdj(&adj_rel);
+inline double taxicabDistance(float *feat1, float *feat2, int num_feats)
+{
+    double dist;
 
-    return seed_set;
+    dist = 0;
+
+    for(int i = 0; i < num_feats; i++)
+        dist += fabs(feat1[i] - feat2[i]);
+
+    return dist;
 }
 
+//=============================================================================
+// Size_t
+//=============================================================================
+static size_t getIFTQueueBytes(IFTQueue *queue)
+{
+    size_t num_bytes;
+
+    if(queue->engine == BUCKET_QUEUE)
+        num_bytes = (size_t)queue->bucket->size * 3 * sizeof(int) + 
+                    (size_t)queue->bucket->num_buckets * 2 * sizeof(int);
+    else
+        num_bytes = (size_t)(queue->heap->size + queue->heap->arity - 1) * sizeof(HeapElem) + 
+                    (size_t)queue->heap->size * sizeof(int);
+
+    // Unless within the nodes
+    if(queue->stamp_stride == 1)
+        num_bytes += (size_t)(queue->engine == BUCKET_QUEUE ? queue->bucket->size : queue->heap->size) * 
+                     sizeof(unsigned int);
 
-IntList *selectKMostRelevantSeeds(Tree **trees, IntList **tree_adj, int num_nodes, int num_trees, int num_maintain)
+    return num_bytes;
+}
+
+static size_t getRegionAdjBytes(RegionAdj *adj)
 {
-    double *tree_prio;
-    IntList *rel_seeds;
-    PrioQueue *queue;
+    return (size_t)adj->capacity * sizeof(uint64_t) + (size_t)(adj->num_regions + 1) * sizeof(int) + 
+           (size_t)adj->elems_capacity * sizeof(int);
+}
 
-    tree_prio = (double*)calloc(num_trees, sizeof(double));
-    rel_seeds = createIntList();
-    queue = createPrioQueue(num_trees, tree_prio, MAXVAL_POLICY);
+static size_t getDISFWorkspaceBytes(DISFWorkspace *ws)
+{
+    size_t num_bytes;
 
-    for(int i = 0; i < num_trees; i++)
-    {
-        double area_prio, grad_prio;
-        float *mean_feat_i;
+    // Per node
+    num_bytes = (size_t)ws->node_capacity * (sizeof(IFTNode) + sizeof(bool) + 3 * sizeof(int));
+    num_bytes += getIFTQueueBytes(ws->queue);
 
-        area_prio = trees[i]->num_nodes/(float)num_nodes;
+    // Per seed
+    num_bytes += (size_t)ws->seed_capacity * (4 * sizeof(int) + sizeof(Tree) + sizeof(Tree*) + sizeof(bool) + 
+                                              sizeof(double) + 2 * ws->num_feats * sizeof(float));
+    num_bytes += (size_t)(ws->seed_capacity + ws->prio_queue->arity - 1) * sizeof(HeapElem) + 
+                 (size_t)ws->seed_capacity * (sizeof(int) + sizeof(unsigned int)); // Selection queue
+    num_bytes += getRegionAdjBytes(ws->tree_adj);
 
-        grad_prio = INFINITY;
-        mean_feat_i = meanTreeFeatVector(trees[i]);
+    if(ws->tiles != NULL)
+    {
+        for(int i = 0; i < ws->tiles->num_tiles; i++)
+            num_bytes += getIFTQueueBytes(ws->tiles->queues[i]) + getRegionAdjBytes(ws->tiles->tree_adj[i]);
 
-        for(IntCell *ptr = tree_adj[i]->head; ptr != NULL; ptr = ptr->next)
-        {
-            int adj_tree_id;
-            float *mean_feat_j;
-            double dist;
+        num_bytes += getIFTQueueBytes(ws->tiles->seam_queue) + 2 * (size_t)ws->node_capacity * sizeof(int);
+    }
 
-            adj_tree_id = ptr->elem;
-            mean_feat_j = meanTreeFeatVector(trees[adj_tree_id]);
+    // Temporal cells
+    num_bytes += (size_t)ws->cell_capacity * (2 * sizeof(float) + sizeof(bool));
 
-            dist = euclDistance(mean_feat_i, mean_feat_j, trees[i]->num_feats);
+    return num_bytes;
+}
 
-            grad_prio = MIN(grad_prio, dist);
+//=============================================================================
+// ElemState
+//=============================================================================
+static inline ElemState getIFTQueueState(IFTQueue *queue, int index)
+{
+    unsigned int stamp, generation;
 
-            free(mean_feat_j);
-        }
+    stamp = queue->stamp[index * queue->stamp_stride];
+    generation = *(queue->generation);
 
-        tree_prio[i] = area_prio * grad_prio;
+    // As in getPrioQueueState, without its dispatch
+    return stamp >= generation ? (ElemState)(stamp - generation) : WHITE_STATE;
+}
 
-        insertPrioQueue(&queue, i);
+//=============================================================================
+// NodeCoords
+//=============================================================================
+inline NodeCoords getAdjacentNodeCoords(NodeAdj *adj_rel, NodeCoords coords, int id)
+{
+    NodeCoords adj_coords;
 
-        free(mean_feat_i);
-    }
+    adj_coords.x = coords.x + adj_rel->dx[id];
+    adj_coords.y = coords.y + adj_rel->dy[id];
 
-    for(int i = 0; i < num_maintain && !isPrioQueueEmpty(queue); i++)
-    {
-        int tree_id, root_index;
+    return adj_coords;
+}
 
-        tree_id = popPrioQueue(&queue);
-        root_index = trees[tree_id]->root_index;
 
-        insertIntListTail(&rel_seeds, root_index);
-    }
+inline NodeCoords getNodeCoords(Graph *graph, int index)
+{
+    NodeCoords coords;
 
-    freePrioQueue(&queue); // The remaining are discarded
-    free(tree_prio);
+    coords.x = index % graph->num_cols;
+    coords.y = index / graph->num_cols;
 
-    return rel_seeds;
+    return coords;
 }
 
 //=============================================================================
-// Void
+// Float*
 //=============================================================================
-void insertNodeInTree(Graph *graph, int index, Tree **tree)
+inline float* meanTreeFeatVector(Tree *tree)
+{
+    float* mean_feat;
+
+    mean_feat = (float*)calloc(tree->num_feats, sizeof(float));
+
+    for(int i = 0; i < tree->num_feats; i++)
+        mean_feat[i] = tree->mean_feat[i];
+
+    return mean_feat;
+}
+
+inline float *getNodeFeats(Graph *graph, int index, float *buffer)
 {
-    (*tree)->num_nodes++;
+    if(graph->layout == INTERLEAVED_LAYOUT)
+        return &(graph->feats[index * graph->num_feats]);
 
     for(int i = 0; i < graph->num_feats; i++)
-        (*tree)->sum_feat[i] += graph->feats[index][i];
-}
\ No newline at end of file
+        buffer[i] = graph->feats[i * graph->num_nodes + index];
+
+    return buffer;
+}
+
+//=============================================================================
+// Double*
+//=============================================================================
+double *computeGradient(Graph *graph)
+{
+    double *grad;
+    NodeAdj *adj_rel;
+
+    grad = (double*)calloc(graph->num_nodes, sizeof(double));
+    adj_rel = create8NeighAdj();
+
+    computeGradientInto(graph, adj_rel, grad);
+
+    freeNodeAdj(&adj_rel);
+
+    return grad;
+}
+
+//=============================================================================
+// Image*
+//=============================================================================
+Image *runDISF(Graph *graph, int n_0, int n_f, Image **border_img)
+{
+    return runDISFWithOptions(graph, n_0, n_f, border_img, NULL);
+}
+
+Image *runDISFWithOptions(Graph *graph, int n_0, int n_f, Image **border_img, DISFOptions *opts)
+{
+    Image *label_img;
+    DISFWorkspace *ws;
+
+    ws = createDISFWorkspace(graph->num_rows, graph->num_cols, n_0, opts);
+
+    runDISFWithWorkspace(ws, graph, n_0, n_f, border_img, opts);
+
+    // The label image is handed over to the caller
+    label_img = ws->label_img;
+    ws->label_img = NULL;
+
+    freeDISFWorkspace(&ws);
+
+    return label_img;
+}
+
+Image *runDISFWithWorkspace(DISFWorkspace *ws, Graph *graph, int n_0, int n_f, Image **border_img, DISFOptions *opts)
+{
+    int num_seeds;
+    DISFOptions default_opts;
+
+    if(opts == NULL)
+    {
+        setDefaultDISFOptions(&default_opts);
+        opts = &default_opts;
+    }
+
+    prepareDISFWorkspace(ws, graph, opts);
+
+    num_seeds = markGridSeeds(graph, ws->adj_rel, n_0, NULL, ws->is_seed);
+    reserveDISFWorkspace(ws, graph->num_nodes, num_seeds, graph->num_feats, opts);
+
+    collectMarkedSeeds(ws, graph);
+
+    ws->has_frame = false; // The cells' reference is not of this image
+
+    runDISFFromSeeds(ws, graph, n_0, n_f, border_img, opts, 1, NULL, NULL);
+
+    return ws->label_img;
+}
+
+Image *runDISFWithPinnedTrees(DISFWorkspace *ws, Graph *graph, int n_0, int n_f, Image **border_img, 
+                              DISFOptions *opts, PinnedTrees *pinned)
+{
+    int num_seeds;
+    DISFOptions pinned_opts;
+
+    if(opts == NULL) setDefaultDISFOptions(&pinned_opts);
+    else pinned_opts = *opts;
+
+    pinned_opts.differential = false;
+    pinned_opts.num_tiles = 1;
+
+    if(pinned->num_feats != graph->num_feats)
+        printError("runDISFWithPinnedTrees", "The pinned trees' features do not match the graph's");
+
+    prepareDISFWorkspace(ws, graph, &pinned_opts);
+
+    num_seeds = markGridSeeds(graph, ws->adj_rel, n_0, NULL, ws->is_seed);
+
+    // The pinned roots already belong to a tree
+    for(int i = 0; i < pinned->num_roots; i++)
+        if(ws->is_seed[pinned->root_nodes[i]])
+        {
+            ws->is_seed[pinned->root_nodes[i]] = false;
+            num_seeds--;
+        }
+
+    reserveDISFWorkspace(ws, graph->num_nodes, pinned->num_trees + num_seeds, graph->num_feats, &pinned_opts);
+
+    collectMarkedSeeds(ws, graph);
+
+    ws->has_frame = false;
+
+    runDISFFromSeeds(ws, graph, n_0, n_f, border_img, &pinned_opts, 1, pinned, NULL);
+
+    return ws->label_img;
+}
+
+Image *runDISFWithHierarchy(Graph *graph, int n_0, int n_f, Image **border_img, DISFOptions *opts, 
+                            DISFHierarchy **hierarchy)
+{
+    int num_seeds;
+    Image *label_img;
+    DISFOptions hier_opts;
+    DISFWorkspace *ws;
+
+    if(opts == NULL) setDefaultDISFOptions(&hier_opts);
+    else hier_opts = *opts;
+
+    hier_opts.differential = false;
+
+    ws = createDISFWorkspace(graph->num_rows, graph->num_cols, n_0, &hier_opts);
+    prepareDISFWorkspace(ws, graph, &hier_opts);
+
+    num_seeds = markGridSeeds(graph, ws->adj_rel, n_0, NULL, ws->is_seed);
+    reserveDISFWorkspace(ws, graph->num_nodes, num_seeds, graph->num_feats, &hier_opts);
+
+    collectMarkedSeeds(ws, graph);
+
+    *hierarchy = createDISFHierarchy(graph, num_seeds);
+
+    runDISFFromSeeds(ws, graph, n_0, n_f, border_img, &hier_opts, 1, NULL, *hierarchy);
+
+    // The label image is handed over to the caller
+    label_img = ws->label_img;
+    ws->label_img = NULL;
+
+    freeDISFWorkspace(&ws);
+
+    return label_img;
+}
+
+Image *getDISFHierarchyLabels(DISFHierarchy *hierarchy, int level)
+{
+    int *id_label;
+    Image *label_img;
+
+    if(level < 0 || level >= hierarchy->num_levels)
+        printError("getDISFHierarchyLabels", "Invalid level <%d> of <%d>", level, hierarchy->num_levels);
+
+    label_img = createImage(hierarchy->num_rows, hierarchy->num_cols, 1);
+
+    memcpy(label_img->val.i32, hierarchy->base_ids, (size_t)hierarchy->num_nodes * sizeof(int));
+
+    for(int i = hierarchy->delta_start[1]; i < hierarchy->delta_start[level + 1]; i++)
+        label_img->val.i32[hierarchy->delta_nodes[i]] = hierarchy->delta_ids[i];
+
+    // Ids are within the initial seed set, i.e., the first level's labels
+    id_label = (int*)calloc(hierarchy->num_superpixels[0], sizeof(int));
+
+    for(int i = 0; i < hierarchy->num_superpixels[level]; i++)
+        id_label[hierarchy->seed_ids[hierarchy->seed_start[level] + i]] = i;
+
+    #pragma omp parallel for
+    for(int i = 0; i < hierarchy->num_nodes; i++)
+        label_img->val.i32[i] = id_label[label_img->val.i32[i]];
+
+    free(id_label);
+
+    return label_img;
+}
+
+Image *runDISFTemporal(DISFWorkspace *ws, Graph *graph, int n_0, int n_f, Image **border_img, DISFOptions *opts)
+{
+    DISFOptions default_opts;
+
+    if(opts == NULL)
+    {
+        setDefaultDISFOptions(&default_opts);
+        opts = &default_opts;
+    }
+
+    if(!ws->has_frame || ws->frame_rows != graph->num_rows || ws->frame_cols != graph->num_cols || 
+       ws->frame_n_0 != n_0)
+    {
+        runDISFWithWorkspace(ws, graph, n_0, n_f, border_img, opts);
+        startTemporalFrame(ws, graph, n_0);
+    }
+    else
+    {
+        int num_seeds, first_iter;
+
+        prepareDISFWorkspace(ws, graph, opts);
+
+        num_seeds = resampleChangedCells(ws, graph, n_0, opts);
+
+        // The schedule is resumed where it falls below the number of seeds
+        first_iter = getScheduleIter(opts, n_0, n_f, num_seeds);
+
+        runDISFFromSeeds(ws, graph, n_0, n_f, border_img, opts, first_iter, NULL, NULL);
+    }
+
+    return ws->label_img;
+}
+
+//=============================================================================
+// IntList*
+//=============================================================================
+IntList *gridSampling(Graph *graph, int num_seeds)
+{
+    return gridSamplingWithGradient(graph, num_seeds, NULL);
+}
+
+IntList *gridSamplingWithGradient(Graph *graph, int num_seeds, double **grad)
+{
+    bool *is_seed;
+    IntList *seed_set;
+    NodeAdj *adj_rel;
+
+    seed_set = createIntList();
+    is_seed = (bool*)calloc(graph->num_nodes, sizeof(bool));
+    adj_rel = create8NeighAdj();
+
+    if(grad != NULL) *grad = (double*)calloc(graph->num_nodes, sizeof(double));
+
+    markGridSeeds(graph, adj_rel, num_seeds, grad != NULL ? *grad : NULL, is_seed);
+
+    for(int i = 0; i < graph->num_nodes; i++)
+        if(is_seed[i]) // Assuring unique values
+            insertIntListTail(&seed_set, i);
+
+    free(is_seed);
+    freeNodeAdj(&adj_rel);
+
+    return seed_set;
+}
+
+
+IntList *selectKMostRelevantSeeds(Tree **trees, RegionAdj *tree_adj, int num_nodes, int num_trees, int num_maintain)
+{
+    int num_rel;
+    int *rel_seeds;
+    double *tree_prio;
+    IntList *seed_set;
+    PrioQueue *queue;
+
+    tree_prio = (double*)calloc(num_trees, sizeof(double));
+    rel_seeds = (int*)calloc(num_trees, sizeof(int));
+    queue = createPrioQueue(num_trees, tree_prio, MAXVAL_POLICY);
+
+    num_rel = selectKMostRelevantTrees(trees, tree_adj, num_nodes, num_trees, 0, num_maintain, tree_prio, queue, rel_seeds);
+
+    seed_set = createIntList();
+    for(int i = num_rel - 1; i >= 0; i--)
+        insertIntListHead(&seed_set, rel_seeds[i]);
+
+    freePrioQueue(&queue);
+    free(rel_seeds);
+    free(tree_prio);
+
+    return seed_set;
+}
+
+//=============================================================================
+// Void
+//=============================================================================
+static void runDISFFromSeeds(DISFWorkspace *ws, Graph *graph, int n_0, int n_f, Image **border_img, 
+                             DISFOptions *opts, int first_iter, PinnedTrees *pinned, DISFHierarchy *hierarchy)
+{
+    int num_rem_seeds, iter, num_seeds, num_pinned;
+    int *tree_ids, *kept_ids;
+    IFTNode *nodes;
+    Image *label_img;
+    IFTQueue *queue;
+    TiledIFT *tiles;
+
+    if(opts->stats != NULL)
+        opts->stats->sampling_time = omp_get_wtime() - ws->start_time;
+
+    if(opts->differential)
+    {
+        runDifferentialDISF(ws, graph, n_0, n_f, border_img, opts, first_iter);
+        return;
+    }
+
+    nodes = ws->nodes;
+    label_img = ws->label_img;
+    queue = ws->queue;
+    num_pinned = pinned != NULL ? pinned->num_trees : 0;
+    tree_ids = kept_ids = NULL;
+
+    // Initial ids of the current trees (by label), for the hierarchy
+    if(hierarchy != NULL)
+    {
+        tree_ids = (int*)calloc(ws->num_seeds, sizeof(int));
+        kept_ids = (int*)calloc(ws->num_seeds, sizeof(int));
+
+        for(int i = 0; i < ws->num_seeds; i++)
+            tree_ids[i] = i;
+    }
+
+    if(opts->num_tiles > 1)
+    {
+        reserveTiledIFT(ws, graph, opts);
+        tiles = ws->tiles;
+    }
+    else tiles = NULL;
+
+    iter = first_iter; // At least a single iteration is performed
+    do
+    {
+        int num_trees, num_maintain;
+        int *tmp_seeds;
+        long prev_counts[3], counts[3];
+        double iter_start, ift_end;
+
+        iter_start = omp_get_wtime();
+
+        if(opts->stats != NULL) getIFTQueueCounts(ws, prev_counts);
+
+        resetRegionAdj(&(ws->tree_adj));
+
+        // The single queue recognizes the previous iteration's nodes as WHITE, but the tiled IFT 
+        // relies on the unconquered nodes' labels
+        if(tiles != NULL)
+        {
+            #pragma omp parallel for
+            for(int i = 0; i < graph->num_nodes; i++)
+            {
+                nodes[i].cost = INFINITY;
+                nodes[i].label = -1;
+            }
+        }
+
+        for(int i = 0; i < num_pinned; i++)
+        {
+            Tree *tree;
+
+            tree = ws->trees[i] = &(ws->tree_pool[i]);
+            resetTree(tree, -1);
+
+            // Their roots are inserted once conquered
+            tree->num_nodes = pinned->num_nodes[i];
+
+            for(int j = 0; j < tree->num_feats && tree->num_nodes > 0; j++)
+            {
+                tree->sum_feat[j] = pinned->sum_feat[i * tree->num_feats + j];
+                tree->mean_feat[j] = tree->sum_feat[j]/(float)tree->num_nodes;
+            }
+        }
+
+        for(int i = 0; num_pinned > 0 && i < pinned->num_roots; i++)
+        {
+            int root_index, label;
+
+            root_index = pinned->root_nodes[i];
+            label = pinned->root_labels[i];
+
+            nodes[root_index].cost = 0;
+            nodes[root_index].label = label;
+
+            if(ws->trees[label]->root_index == -1) ws->trees[label]->root_index = root_index;
+
+            insertIFTQueue(queue, root_index);
+        }
+
+        for(int i = 0; i < ws->num_seeds; i++)
+        {   
+            int seed_index;
+
+            seed_index = ws->seeds[i];
+
+            nodes[seed_index].cost = 0;
+            nodes[seed_index].label = num_pinned + i;
+
+            ws->trees[num_pinned + i] = &(ws->tree_pool[num_pinned + i]);
+            resetTree(ws->trees[num_pinned + i], seed_index);
+
+            if(tiles == NULL) insertIFTQueue(queue, seed_index);
+        }
+
+        if(tiles == NULL)
+            growForest(graph, ws->adj_rel, nodes, queue, 0, graph->num_rows, ws->trees, ws->tree_adj, 
+                       NULL, NULL);
+        else
+        {
+            int seam_width;
+
+            // Wider bands than half a tile would serialize most of the work
+            if(opts->seam_width > 0) seam_width = opts->seam_width;
+            else seam_width = MIN((int)ceil(sqrt(graph->num_nodes / (double)ws->num_seeds)), 
+                                  MAX(graph->num_rows / (2 * tiles->num_tiles), 1));
+
+            growTiledForest(graph, ws->adj_rel, nodes, tiles, ws->trees, ws->num_seeds, 
+                            ws->tree_adj, seam_width);
+        }
+
+        ift_end = omp_get_wtime();
+
+        if(hierarchy != NULL)
+            recordDISFHierarchyLevel(hierarchy, nodes, tree_ids, ws->num_seeds);
+
+        num_maintain = getNumMaintainedTrees(opts, iter, n_0, n_f);
+
+        // Aux
+        num_trees = num_pinned + ws->num_seeds;
+
+        num_seeds = selectKMostRelevantTrees(ws->trees, ws->tree_adj, graph->num_nodes, num_trees, num_pinned,
+                                             num_maintain, ws->tree_prio, ws->prio_queue, ws->kept_seeds);
+
+        num_rem_seeds = ws->num_seeds - num_seeds;
+
+        if(opts->stats != NULL)
+        {
+            getIFTQueueCounts(ws, counts);
+            recordDISFStatsIter(opts->stats, num_trees, ift_end - iter_start, omp_get_wtime() - ift_end, 
+                                prev_counts, counts);
+        }
+
+        if(!continueDISFRun(ws, opts, iter - first_iter + 1, ws->num_seeds, omp_get_wtime() - iter_start) && 
+           num_rem_seeds > 0)
+        {
+            ws->has_reached_target = false;
+            num_rem_seeds = 0; // The current forest is returned
+        }
+
+        // The seeds of the final forest are kept in the workspace
+        if(num_rem_seeds > 0)
+        {
+            if(hierarchy != NULL)
+            {
+                for(int i = 0; i < num_seeds; i++)
+                    kept_ids[i] = tree_ids[nodes[ws->kept_seeds[i]].label];
+
+                tmp_seeds = tree_ids;
+                tree_ids = kept_ids;
+                kept_ids = tmp_seeds;
+            }
+
+            tmp_seeds = ws->seeds;
+            ws->seeds = ws->kept_seeds;
+            ws->kept_seeds = tmp_seeds;
+            ws->num_seeds = num_seeds;
+        }
+        
+        iter++;
+        resetIFTQueue(queue);
+    } while(num_rem_seeds > 0);
+
+    free(tree_ids);
+    free(kept_ids);
+
+    #pragma omp parallel for
+    for(int i = 0; i < graph->num_nodes; i++)
+        label_img->val.i32[i] = nodes[i].label;
+
+    // Of the final forest only
+    if(border_img != NULL)
+        computeBorderImage(graph, label_img, ws->adj_rel, *border_img);
+
+    if(opts->stats != NULL)
+    {
+        opts->stats->total_time = omp_get_wtime() - ws->start_time;
+        opts->stats->has_reached_target = ws->has_reached_target;
+        opts->stats->peak_bytes = getDISFWorkspaceBytes(ws) + (size_t)graph->num_nodes * graph->num_feats * sizeof(float);
+    }
+}
+
+static void runDifferentialDISF(DISFWorkspace *ws, Graph *graph, int n_0, int n_f, Image **border_img, 
+                                DISFOptions *opts, int first_iter)
+{
+    int num_rem_seeds, iter, num_init_trees, num_alive;
+    int *tree_first, *next_in_tree, *inval_nodes, *label_map;
+    long prev_counts[3];
+    bool *is_kept;
+    IFTNode *nodes;
+    NodeAdj *adj_rel;
+    Image *label_img;
+    IFTQueue *queue;
+    Tree **trees;
+
+    // Aux
+    nodes = ws->nodes;
+    adj_rel = ws->adj_rel;
+    label_img = ws->label_img;
+    queue = ws->queue;
+    inval_nodes = ws->inval_nodes;
+    next_in_tree = ws->next_in_tree;
+    trees = ws->trees;
+    tree_first = ws->tree_first;
+    is_kept = ws->is_kept;
+    label_map = ws->label_map;
+
+    // Trees are identified by their seed's position in the initial seed set
+    num_init_trees = ws->num_seeds;
+    resetRegionAdj(&(ws->tree_adj));
+
+    if(opts->stats != NULL) getIFTQueueCounts(ws, prev_counts);
+
+    #pragma omp parallel for
+    for(int i = 0; i < graph->num_nodes; i++)
+    {
+        nodes[i].cost = INFINITY;
+        nodes[i].label = -1;
+    }
+
+    for(num_alive = 0; num_alive < num_init_trees; num_alive++)
+    {
+        int seed_index;
+
+        seed_index = ws->seeds[num_alive];
+
+        nodes[seed_index].cost = 0;
+        nodes[seed_index].label = num_alive;
+
+        trees[num_alive] = &(ws->tree_pool[num_alive]);
+        resetTree(trees[num_alive], seed_index);
+        tree_first[num_alive] = -1;
+
+        insertIFTQueue(queue, seed_index);
+    }
+
+    iter = first_iter; // At least a single iteration is performed
+    do
+    {
+        int num_maintain, num_inval, num_kept;
+        int *tmp_seeds;
+        long counts[3];
+        double iter_start, ift_end;
+
+        iter_start = omp_get_wtime();
+
+        // Borders are computed once, at the end
+        growForest(graph, adj_rel, nodes, queue, 0, graph->num_rows, trees, ws->tree_adj, 
+                   tree_first, next_in_tree);
+
+        ift_end = omp_get_wtime();
+
+        num_maintain = getNumMaintainedTrees(opts, iter, n_0, n_f);
+
+        num_kept = selectKMostRelevantTrees(trees, ws->tree_adj, graph->num_nodes, num_init_trees, 0, num_maintain,
+                                            ws->tree_prio, ws->prio_queue, ws->kept_seeds);
+
+        num_rem_seeds = num_alive - num_kept;
+
+        if(opts->stats != NULL)
+        {
+            getIFTQueueCounts(ws, counts);
+            recordDISFStatsIter(opts->stats, num_alive, ift_end - iter_start, omp_get_wtime() - ift_end, 
+                                prev_counts, counts);
+
+            // The next IFT starts with the invalidation
+            for(int i = 0; i < 3; i++)
+                prev_counts[i] = counts[i];
+        }
+
+        if(!continueDISFRun(ws, opts, iter - first_iter + 1, num_alive, omp_get_wtime() - iter_start) && 
+           num_rem_seeds > 0)
+        {
+            ws->has_reached_target = false;
+            num_rem_seeds = 0;
+        }
+        iter++;
+
+        if(num_rem_seeds == 0)
+            break; // The current forest is the final one
+
+        tmp_seeds = ws->seeds;
+        ws->seeds = ws->kept_seeds;
+        ws->kept_seeds = tmp_seeds;
+        ws->num_seeds = num_kept;
+
+        for(int i = 0; i < num_init_trees; i++)
+            is_kept[i] = false;
+        for(int i = 0; i < ws->num_seeds; i++)
+            is_kept[nodes[ws->seeds[i]].label] = true;
+
+        // Invalidates the nodes of the removed trees
+        num_inval = 0;
+        for(int i = 0; i < num_init_trees; i++)
+        {
+            if(trees[i] == NULL || is_kept[i]) continue;
+
+            for(int index = tree_first[i]; index != -1; index = next_in_tree[index])
+            {
+                nodes[index].cost = INFINITY;
+                nodes[index].label = -1;
+                setIFTQueueState(queue, index, WHITE_STATE);
+
+                inval_nodes[num_inval] = index;
+                num_inval++;
+            }
+
+            trees[i] = NULL; // Its pool slot is left unused
+            tree_first[i] = -1;
+        }
+        num_alive = ws->num_seeds;
+
+        // The kept trees must forget the removed ones
+        keepRegionAdjPairs(&(ws->tree_adj), is_kept);
+
+        // The removed regions are re-conquered from their frontier with the kept trees
+        seedInvalidatedNodes(graph, adj_rel, nodes, queue, trees, inval_nodes, num_inval);
+    } while(true);
+
+    resetIFTQueue(queue);
+
+    // Relabels as in the non-differential mode (i.e., in the order of the seed set)
+    for(int i = 0; i < num_init_trees; i++)
+        label_map[i] = -1;
+
+    for(int i = 0; i < ws->num_seeds; i++)
+        label_map[nodes[ws->seeds[i]].label] = i;
+
+    #pragma omp parallel for
+    for(int i = 0; i < graph->num_nodes; i++)
+        label_img->val.i32[i] = label_map[nodes[i].label];
+
+    if(border_img != NULL)
+        computeBorderImage(graph, label_img, adj_rel, *border_img);
+
+    if(opts->stats != NULL)
+    {
+        opts->stats->total_time = omp_get_wtime() - ws->start_time;
+        opts->stats->has_reached_target = ws->has_reached_target;
+        opts->stats->peak_bytes = getDISFWorkspaceBytes(ws) + (size_t)graph->num_nodes * graph->num_feats * sizeof(float);
+    }
+}
+
+static void computeGradientInto(Graph *graph, NodeAdj *adj_rel, double *grad)
+{
+    bool is_unit_adj;
+    int num_rows, num_cols;
+    float dist_weight[adj_rel->size];
+
+    computeGradientWeights(adj_rel, dist_weight);
+
+    num_rows = graph->num_rows;
+    num_cols = graph->num_cols;
+
+    is_unit_adj = true;
+    for(int j = 0; j < adj_rel->size; j++)
+        is_unit_adj = is_unit_adj && abs(adj_rel->dx[j]) <= 1 && abs(adj_rel->dy[j]) <= 1;
+
+    if(is_unit_adj && graph->num_feats == 3 && num_rows >= 3 && num_cols >= 3)
+    {
+        // Interior, a row at a time
+        #pragma omp parallel for
+        for(int y = 1; y < num_rows - 1; y++)
+            computeInteriorGradient(graph, adj_rel, dist_weight, y, y + 1, grad);
+
+        // 1-pixel frame
+        #pragma omp parallel for
+        for(int x = 0; x < num_cols; x++)
+        {
+            grad[x] = computeNodeGradient(graph, adj_rel, dist_weight, x);
+            grad[(num_rows - 1) * num_cols + x] = computeNodeGradient(graph, adj_rel, dist_weight, 
+                                                                      (num_rows - 1) * num_cols + x);
+        }
+
+        #pragma omp parallel for
+        for(int y = 1; y < num_rows - 1; y++)
+        {
+            grad[y * num_cols] = computeNodeGradient(graph, adj_rel, dist_weight, y * num_cols);
+            grad[y * num_cols + num_cols - 1] = computeNodeGradient(graph, adj_rel, dist_weight, 
+                                                                    y * num_cols + num_cols - 1);
+        }
+    }
+    else
+    {
+        #pragma omp parallel for
+        for(int i = 0; i < graph->num_nodes; i++)
+            grad[i] = computeNodeGradient(graph, adj_rel, dist_weight, i);
+    }
+}
+
+SIMD_TARGET_CLONES
+static void computeInteriorGradient(Graph *graph, NodeAdj *adj_rel, float *dist_weight, int row_begin, 
+                                    int row_end, double *grad)
+{
+    int num_cols, num_inner;
+
+    num_cols = graph->num_cols;
+    num_inner = num_cols - 2;
+
+    for(int y = row_begin; y < row_end; y++)
+    {
+        int first_index;
+        double *row_grad;
+
+        first_index = y * num_cols + 1;
+        row_grad = &(grad[first_index]);
+
+        for(int x = 0; x < num_inner; x++)
+            row_grad[x] = 0;
+
+        // An adjacent at a time, which accumulates as computeNodeGradient
+        for(int j = 0; j < adj_rel->size; j++)
+        {
+            int adj_index;
+
+            adj_index = first_index + adj_rel->dy[j] * num_cols + adj_rel->dx[j];
+
+            // Constant strides, so that each layout is vectorized
+            if(graph->layout == INTERLEAVED_LAYOUT)
+                accumulateGradientRow(&(graph->feats[first_index * 3]), &(graph->feats[adj_index * 3]), 
+                                      3, 1, num_inner, dist_weight[j], row_grad);
+            else
+                accumulateGradientRow(&(graph->feats[first_index]), &(graph->feats[adj_index]), 
+                                      1, graph->num_nodes, num_inner, dist_weight[j], row_grad);
+        }
+    }
+}
+
+static inline void accumulateGradientRow(float *feats, float *adj_feats, int node_stride, int feat_stride, 
+                                         int num_nodes, float weight, double *grad)
+{
+    for(int x = 0; x < num_nodes; x++)
+    {
+        double dist;
+
+        dist = 0;
+
+        for(int f = 0; f < 3; f++)
+            dist += fabs(adj_feats[x * node_stride + f * feat_stride] - feats[x * node_stride + f * feat_stride]);
+
+        grad[x] += dist * weight;
+    }
+}
+
+static void computeGradientWeights(NodeAdj *adj_rel, float *dist_weight)
+{
+    float max_adj_dist, sum_weight;
+
+    max_adj_dist = sqrtf(2); // Diagonal distance for 8-neighborhood
+    sum_weight = 0;
+    
+    // Closer --> higher weight
+    for(int i = 0; i < adj_rel->size; i++)
+    {
+        float div;
+
+        div = sqrtf(adj_rel->dx[i] * adj_rel->dx[i] + adj_rel->dy[i] * adj_rel->dy[i]);
+        
+        dist_weight[i] = max_adj_dist / div;
+        sum_weight += dist_weight[i];
+    }
+
+    for(int i = 0; i < adj_rel->size; i++)
+        dist_weight[i] /= sum_weight;
+}
+
+static void growForest(Graph *graph, NodeAdj *adj_rel, IFTNode *nodes, IFTQueue *queue,
+                       int row_begin, int row_end, Tree **trees, RegionAdj *tree_adj, int *tree_first, 
+                       int *next_in_tree)
+{
+    int offset;
+
+    offset = row_begin * graph->num_cols; // Queue index = node index - offset
+
+    while(!isIFTQueueEmpty(queue))
+    {
+        int node_index, node_label;
+        NodeCoords node_coords;
+        float adj_feats_buf[graph->num_feats];
+        float *mean_feat_tree;
+
+        node_index = popIFTQueue(queue) + offset;
+        node_coords = getNodeCoords(graph, node_index);
+        node_label = nodes[node_index].label;
+
+        // This node won't appear here ever again
+        insertNodeInTree(graph, node_index, &(trees[node_label]));
+
+        if(tree_first != NULL)
+        {
+            next_in_tree[node_index] = tree_first[node_label];
+            tree_first[node_label] = node_index;
+        }
+
+        mean_feat_tree = trees[node_label]->mean_feat;
+
+        for(int i = 0; i < adj_rel->size; i++)
+        {
+            NodeCoords adj_coords;
+
+            adj_coords = getAdjacentNodeCoords(adj_rel, node_coords, i);
+
+            if(areValidNodeCoords(graph, adj_coords) && adj_coords.y >= row_begin && adj_coords.y < row_end)
+            {
+                int adj_index;
+                ElemState adj_state;
+
+                adj_index = getNodeIndex(graph, adj_coords);
+                adj_state = getIFTQueueState(queue, adj_index - offset);
+
+                // If it wasn't inserted nor orderly removed from the queue
+                if(adj_state != BLACK_STATE)
+                {
+                    double arc_cost, path_cost, adj_cost;
+
+                    arc_cost = euclDistance(mean_feat_tree, getNodeFeats(graph, adj_index, adj_feats_buf), graph->num_feats);
+
+                    path_cost = MAX(nodes[node_index].cost, arc_cost);
+                    adj_cost = adj_state == GRAY_STATE ? nodes[adj_index].cost : INFINITY;
+
+                    if(path_cost < adj_cost)
+                    {
+                        nodes[adj_index].cost = path_cost;
+                        nodes[adj_index].label = node_label;
+
+                        if(adj_state == GRAY_STATE) decreaseIFTQueue(queue, adj_index - offset);
+                        else insertIFTQueue(queue, adj_index - offset);
+                    }
+                }
+                else if(tree_adj != NULL)
+                {
+                    int adj_label;
+
+                    adj_label = nodes[adj_index].label;
+
+                    if(node_label != adj_label) // Their trees are adjacent
+                        insertRegionAdjPair(&tree_adj, node_label, adj_label);
+                }
+            }
+        }
+    }
+}
+
+static void growTiledForest(Graph *graph, NodeAdj *adj_rel, IFTNode *nodes, TiledIFT *tiles,
+                            Tree **trees, int num_trees, RegionAdj *tree_adj, int seam_width)
+{
+    int num_inval;
+
+    // Each seed is inserted at the queue of its tile
+    for(int i = 0; i < num_trees; i++)
+    {
+        int tile, row;
+
+        row = trees[i]->root_index / graph->num_cols;
+
+        tile = 0;
+        while(row >= tiles->row_begin[tile + 1]) tile++;
+
+        insertIFTQueue(tiles->queues[tile], trees[i]->root_index - tiles->row_begin[tile] * graph->num_cols);
+    }
+
+    // A tree is only conquered by the tile of its root, thus no sharing occurs
+    #pragma omp parallel for schedule(dynamic)
+    for(int t = 0; t < tiles->num_tiles; t++)
+    {
+        growForest(graph, adj_rel, nodes, tiles->queues[t], tiles->row_begin[t], 
+                   tiles->row_begin[t + 1], trees, NULL, NULL, NULL);
+        resetIFTQueue(tiles->queues[t]);
+    }
+
+    // Every node is conquered at this point, except those in tiles without seeds
+    #pragma omp parallel for
+    for(int i = 0; i < graph->num_nodes; i++)
+        setIFTQueueState(tiles->seam_queue, i, nodes[i].label == -1 ? WHITE_STATE : BLACK_STATE);
+
+    num_inval = 0;
+    for(int t = 0; t < tiles->num_tiles; t++)
+        if(nodes[tiles->row_begin[t] * graph->num_cols].label == -1)
+            for(int i = tiles->row_begin[t] * graph->num_cols; i < tiles->row_begin[t + 1] * graph->num_cols; i++)
+                tiles->inval_nodes[num_inval++] = i;
+
+    if(num_inval > 0)
+    {
+        seedInvalidatedNodes(graph, adj_rel, nodes, tiles->seam_queue, trees, tiles->inval_nodes, num_inval);
+        growForest(graph, adj_rel, nodes, tiles->seam_queue, 0, graph->num_rows, trees, 
+                   NULL, NULL, NULL);
+    }
+
+    for(int t = 1; t < tiles->num_tiles; t++)
+        repairTileSeam(graph, adj_rel, nodes, tiles, trees, num_trees, 
+                       tiles->row_begin[t], seam_width);
+
+    // Tree adjacency from the final labels. Each pair of nodes is visited once
+    #pragma omp parallel for schedule(dynamic)
+    for(int t = 0; t < tiles->num_tiles; t++)
+    {
+        resetRegionAdj(&(tiles->tree_adj[t]));
+
+        for(int y = tiles->row_begin[t]; y < tiles->row_begin[t + 1]; y++)
+            for(int x = 0; x < graph->num_cols; x++)
+            {
+                int index, label;
+                NodeCoords coords;
+
+                coords.x = x; coords.y = y;
+                index = getNodeIndex(graph, coords);
+                label = nodes[index].label;
+
+                // Right, Bottom-Left, Bottom-Center and Bottom-Right
+                for(int dy = 0; dy <= 1; dy++)
+                    for(int dx = -dy; dx <= 1; dx++)
+                    {
+                        NodeCoords adj_coords;
+
+                        if(dx == 0 && dy == 0) continue;
+
+                        adj_coords.x = x + dx; adj_coords.y = y + dy;
+
+                        if(areValidNodeCoords(graph, adj_coords))
+                        {
+                            int adj_label;
+
+                            adj_label = nodes[getNodeIndex(graph, adj_coords)].label;
+
+                            if(adj_label != label)
+                                insertRegionAdjPair(&(tiles->tree_adj[t]), label, adj_label);
+                        }
+                    }
+            }
+    }
+
+    for(int t = 0; t < tiles->num_tiles; t++)
+        mergeRegionAdj(&tree_adj, tiles->tree_adj[t]);
+}
+
+static void repairTileSeam(Graph *graph, NodeAdj *adj_rel, IFTNode *nodes, TiledIFT *tiles,
+                           Tree **trees, int num_trees, int seam_row, int seam_width)
+{
+    int band_begin, band_end, num_inval;
+    IFTQueue *queue;
+
+    queue = tiles->seam_queue;
+    band_begin = MAX(seam_row - seam_width, 0);
+    band_end = MIN(seam_row + seam_width, graph->num_rows);
+    num_inval = 0;
+
+    // Trees rooted within the band are entirely re-grown from their roots
+    for(int i = 0; i < num_trees; i++)
+    {
+        int root_index, root_row, stack_size;
+
+        root_index = trees[i]->root_index;
+        root_row = root_index / graph->num_cols;
+
+        if(root_row < band_begin || root_row >= band_end) continue;
+
+        stack_size = 0;
+        tiles->node_stack[stack_size++] = root_index;
+
+        // Trees are connected, and the root keeps its label as a visited mark
+        while(stack_size > 0)
+        {
+            int node_index;
+            NodeCoords node_coords;
+
+            node_index = tiles->node_stack[--stack_size];
+            node_coords = getNodeCoords(graph, node_index);
+
+            for(int j = 0; j < adj_rel->size; j++)
+            {
+                NodeCoords adj_coords;
+
+                adj_coords = getAdjacentNodeCoords(adj_rel, node_coords, j);
+
+                if(areValidNodeCoords(graph, adj_coords))
+                {
+                    int adj_index;
+
+                    adj_index = getNodeIndex(graph, adj_coords);
+
+                    if(adj_index != root_index && nodes[adj_index].label == i)
+                    {
+                        nodes[adj_index].cost = INFINITY;
+                        nodes[adj_index].label = -1;
+                        setIFTQueueState(queue, adj_index, WHITE_STATE);
+
+                        tiles->inval_nodes[num_inval++] = adj_index;
+                        tiles->node_stack[stack_size++] = adj_index;
+                    }
+                }
+            }
+        }
+
+        for(int j = 0; j < trees[i]->num_feats; j++)
+            trees[i]->sum_feat[j] = trees[i]->mean_feat[j] = 0;
+        trees[i]->num_nodes = 0;
+
+        setIFTQueueState(queue, root_index, WHITE_STATE);
+        insertIFTQueue(queue, root_index); // Its cost remains 0
+    }
+
+    // The remaining nodes within the band
+    for(int i = band_begin * graph->num_cols; i < band_end * graph->num_cols; i++)
+    {
+        int label;
+
+        label = nodes[i].label;
+
+        if(label != -1 && getIFTQueueState(queue, i) == BLACK_STATE)
+        {
+            removeNodeFromTree(graph, i, &(trees[label]));
+
+            nodes[i].cost = INFINITY;
+            nodes[i].label = -1;
+            setIFTQueueState(queue, i, WHITE_STATE);
+
+            tiles->inval_nodes[num_inval++] = i;
+        }
+    }
+
+    // The invalidated nodes are re-conquered from their frontier, across the seam
+    seedInvalidatedNodes(graph, adj_rel, nodes, queue, trees, tiles->inval_nodes, num_inval);
+
+    growForest(graph, adj_rel, nodes, queue, 0, graph->num_rows, trees, NULL, NULL, NULL);
+}
+
+static void seedInvalidatedNodes(Graph *graph, NodeAdj *adj_rel, IFTNode *nodes, 
+                                 IFTQueue *queue, Tree **trees, int *inval_nodes, int num_inval)
+{
+    for(int i = 0; i < num_inval; i++)
+    {
+        int node_index;
+        NodeCoords node_coords;
+        float feats_buf[graph->num_feats];
+        float *feats;
+
+        node_index = inval_nodes[i];
+        node_coords = getNodeCoords(graph, node_index);
+        feats = getNodeFeats(graph, node_index, feats_buf);
+
+        for(int j = 0; j < adj_rel->size; j++)
+        {
+            NodeCoords adj_coords;
+
+            adj_coords = getAdjacentNodeCoords(adj_rel, node_coords, j);
+
+            if(areValidNodeCoords(graph, adj_coords))
+            {
+                int adj_index, adj_label;
+
+                adj_index = getNodeIndex(graph, adj_coords);
+                adj_label = nodes[adj_index].label;
+
+                if(adj_label != -1 && getIFTQueueState(queue, adj_index) == BLACK_STATE)
+                {
+                    double path_cost;
+
+                    path_cost = MAX(nodes[adj_index].cost, euclDistance(trees[adj_label]->mean_feat, feats, graph->num_feats));
+
+                    if(path_cost < nodes[node_index].cost)
+                    {
+                        nodes[node_index].cost = path_cost;
+                        nodes[node_index].label = adj_label;
+                    }
+                }
+            }
+        }
+
+        if(nodes[node_index].label != -1)
+            insertIFTQueue(queue, node_index);
+    }
+}
+
+static void computeBorderImage(Graph *graph, Image *label_img, NodeAdj *adj_rel, Image *border_img)
+{
+    #pragma omp parallel for
+    for(int i = 0; i < graph->num_nodes; i++)
+    {
+        bool is_border;
+        NodeCoords coords;
+
+        is_border = false;
+        coords = getNodeCoords(graph, i);
+
+        for(int j = 0; j < adj_rel->size && !is_border; j++)
+        {
+            NodeCoords adj_coords;
+
+            adj_coords = getAdjacentNodeCoords(adj_rel, coords, j);
+
+            if(areValidNodeCoords(graph, adj_coords))
+                is_border = label_img->val.i32[getNodeIndex(graph, adj_coords)] != label_img->val.i32[i];
+        }
+
+        setImageVal(border_img, i, 0, is_border ? 255 : 0);
+    }
+}
+
+static void recordDISFHierarchyLevel(DISFHierarchy *hierarchy, IFTNode *nodes, int *tree_ids, int num_trees)
+{
+    int level, num_deltas;
+
+    level = hierarchy->num_levels;
+
+    if(level == hierarchy->level_capacity)
+    {
+        hierarchy->level_capacity *= 2;
+        hierarchy->num_superpixels = (int*)realloc(hierarchy->num_superpixels, 
+                                                   hierarchy->level_capacity * sizeof(int));
+        hierarchy->seed_start = (int*)realloc(hierarchy->seed_start, (hierarchy->level_capacity + 1) * sizeof(int));
+        hierarchy->delta_start = (int*)realloc(hierarchy->delta_start, (hierarchy->level_capacity + 1) * sizeof(int));
+    }
+
+    if(hierarchy->seed_start[level] + num_trees > hierarchy->seed_capacity)
+    {
+        hierarchy->seed_capacity = MAX(2 * hierarchy->seed_capacity, hierarchy->seed_start[level] + num_trees);
+        hierarchy->seed_ids = (int*)realloc(hierarchy->seed_ids, hierarchy->seed_capacity * sizeof(int));
+    }
+
+    hierarchy->num_superpixels[level] = num_trees;
+    memcpy(&(hierarchy->seed_ids[hierarchy->seed_start[level]]), tree_ids, num_trees * sizeof(int));
+    hierarchy->seed_start[level + 1] = hierarchy->seed_start[level] + num_trees;
+
+    num_deltas = hierarchy->delta_start[level];
+
+    if(level == 0)
+    {
+        #pragma omp parallel for
+        for(int i = 0; i < hierarchy->num_nodes; i++)
+            hierarchy->base_ids[i] = hierarchy->curr_ids[i] = tree_ids[nodes[i].label];
+    }
+    else
+    {
+        // Only the nodes whose tree changed
+        for(int i = 0; i < hierarchy->num_nodes; i++)
+        {
+            int id;
+
+            id = tree_ids[nodes[i].label];
+
+            if(id != hierarchy->curr_ids[i])
+            {
+                if(num_deltas == hierarchy->delta_capacity)
+                {
+                    hierarchy->delta_capacity *= 2;
+                    hierarchy->delta_nodes = (int*)realloc(hierarchy->delta_nodes, 
+                                                           hierarchy->delta_capacity * sizeof(int));
+                    hierarchy->delta_ids = (int*)realloc(hierarchy->delta_ids, 
+                                                         hierarchy->delta_capacity * sizeof(int));
+                }
+
+                hierarchy->delta_nodes[num_deltas] = i;
+                hierarchy->delta_ids[num_deltas] = id;
+                num_deltas++;
+
+                hierarchy->curr_ids[i] = id;
+            }
+        }
+    }
+
+    hierarchy->delta_start[level + 1] = num_deltas;
+    hierarchy->num_levels++;
+}
+
+void insertNodeInTree(Graph *graph, int index, Tree **tree)
+{
+    Tree *tmp;
+
+    tmp = *tree;
+
+    tmp->num_nodes++;
+
+    for(int i = 0; i < graph->num_feats; i++)
+    {
+        tmp->sum_feat[i] += getNodeFeat(graph, index, i);
+        tmp->mean_feat[i] = tmp->sum_feat[i]/(float)tmp->num_nodes;
+    }
+}
+
+void removeNodeFromTree(Graph *graph, int index, Tree **tree)
+{
+    Tree *tmp;
+
+    tmp = *tree;
+
+    tmp->num_nodes--;
+
+    for(int i = 0; i < graph->num_feats; i++)
+    {
+        tmp->sum_feat[i] -= getNodeFeat(graph, index, i);
+
+        if(tmp->num_nodes > 0) tmp->mean_feat[i] = tmp->sum_feat[i]/(float)tmp->num_nodes;
+        else tmp->sum_feat[i] = tmp->mean_feat[i] = 0;
+    }
+}
+
+static void collectMarkedSeeds(DISFWorkspace *ws, Graph *graph)
+{
+    // In the order of gridSampling's seed set
+    ws->num_seeds = 0;
+    for(int i = graph->num_nodes - 1; i >= 0; i--)
+        if(ws->is_seed[i])
+        {
+            ws->seeds[ws->num_seeds++] = i;
+            ws->is_seed[i] = false;
+        }
+}
+
+static void getIFTQueueCounts(DISFWorkspace *ws, long *counts)
+{
+    counts[0] = ws->queue->num_pushes;
+    counts[1] = ws->queue->num_pops;
+    counts[2] = ws->queue->num_decreases;
+
+    // The tiles' queues, and then the seam's
+    for(int i = 0; ws->tiles != NULL && i <= ws->tiles->num_tiles; i++)
+    {
+        IFTQueue *queue;
+
+        queue = i < ws->tiles->num_tiles ? ws->tiles->queues[i] : ws->tiles->seam_queue;
+
+        counts[0] += queue->num_pushes;
+        counts[1] += queue->num_pops;
+        counts[2] += queue->num_decreases;
+    }
+}
+
+static void recordDISFStatsIter(DISFStats *stats, int num_trees, double ift_time, double selection_time, 
+                                long *prev_counts, long *counts)
+{
+    int iter;
+
+    iter = stats->num_iters;
+
+    if(iter == stats->iter_capacity)
+    {
+        stats->iter_capacity *= 2;
+        stats->num_trees = (int*)realloc(stats->num_trees, stats->iter_capacity * sizeof(int));
+        stats->ift_time = (double*)realloc(stats->ift_time, stats->iter_capacity * sizeof(double));
+        stats->selection_time = (double*)realloc(stats->selection_time, stats->iter_capacity * sizeof(double));
+        stats->num_pushes = (long*)realloc(stats->num_pushes, stats->iter_capacity * sizeof(long));
+        stats->num_pops = (long*)realloc(stats->num_pops, stats->iter_capacity * sizeof(long));
+        stats->num_decreases = (long*)realloc(stats->num_decreases, stats->iter_capacity * sizeof(long));
+    }
+
+    stats->num_trees[iter] = num_trees;
+    stats->ift_time[iter] = ift_time;
+    stats->selection_time[iter] = selection_time;
+    stats->num_pushes[iter] = counts[0] - prev_counts[0];
+    stats->num_pops[iter] = counts[1] - prev_counts[1];
+    stats->num_decreases[iter] = counts[2] - prev_counts[2];
+    stats->num_iters++;
+}
+
+static void checkRemovalSchedule(DISFOptions *opts)
+{
+    switch(opts->schedule)
+    {
+        case GEOMETRIC_SCHEDULE: case LINEAR_SCHEDULE:
+            if(opts->num_stages < 1)
+                printError("checkRemovalSchedule", "The number of stages must be >= 1");
+            break;
+        case CUSTOM_SCHEDULE:
+            if(opts->schedule_func == NULL)
+                printError("checkRemovalSchedule", "No schedule function was given");
+            break;
+        default:
+            if(!(opts->schedule_rate > 0)) // NaN included
+                printError("checkRemovalSchedule", "The schedule rate must be > 0");
+    }
+}
+
+static void prepareDISFWorkspace(DISFWorkspace *ws, Graph *graph, DISFOptions *opts)
+{
+    checkRemovalSchedule(opts);
+
+    ws->start_time = omp_get_wtime();
+    ws->has_reached_target = true;
+
+    if(opts->stats != NULL)
+    {
+        opts->stats->sampling_time = opts->stats->total_time = 0;
+        opts->stats->num_iters = 0;
+        opts->stats->peak_bytes = 0;
+    }
+
+    reserveDISFWorkspace(ws, graph->num_nodes, 0, graph->num_feats, opts);
+
+    ws->label_img->num_rows = graph->num_rows;
+    ws->label_img->num_cols = graph->num_cols;
+    ws->label_img->num_pixels = graph->num_nodes;
+}
+
+static void startTemporalFrame(DISFWorkspace *ws, Graph *graph, int n_0)
+{
+    int num_cells;
+
+    ws->cell_size = MAX((int)getGridStride(graph->num_nodes, n_0), 1);
+    ws->num_cell_rows = (graph->num_rows + ws->cell_size - 1) / ws->cell_size;
+    ws->num_cell_cols = (graph->num_cols + ws->cell_size - 1) / ws->cell_size;
+    num_cells = ws->num_cell_rows * ws->num_cell_cols;
+
+    if(num_cells * graph->num_feats > ws->cell_capacity)
+    {
+        free(ws->ref_cell_feats); free(ws->cell_feats); free(ws->is_cell_changed);
+
+        ws->cell_capacity = num_cells * graph->num_feats;
+        ws->ref_cell_feats = (float*)calloc(ws->cell_capacity, sizeof(float));
+        ws->cell_feats = (float*)calloc(ws->cell_capacity, sizeof(float));
+        ws->is_cell_changed = (bool*)calloc(ws->cell_capacity, sizeof(bool));
+    }
+
+    computeCellMeans(graph, ws->cell_size, ws->num_cell_rows, ws->num_cell_cols, ws->ref_cell_feats);
+
+    ws->frame_rows = graph->num_rows;
+    ws->frame_cols = graph->num_cols;
+    ws->frame_n_0 = n_0;
+    ws->has_frame = true;
+}
+
+static void computeCellMeans(Graph *graph, int cell_size, int num_cell_rows, int num_cell_cols, float *cell_feats)
+{
+    #pragma omp parallel for
+    for(int cy = 0; cy < num_cell_rows; cy++)
+    {
+        int row_end;
+        float feats_buf[graph->num_feats];
+
+        row_end = MIN((cy + 1) * cell_size, graph->num_rows);
+
+        for(int cx = 0; cx < num_cell_cols; cx++)
+        {
+            int col_end, num_nodes;
+            double sum_feat[graph->num_feats];
+
+            col_end = MIN((cx + 1) * cell_size, graph->num_cols);
+            num_nodes = 0;
+
+            for(int j = 0; j < graph->num_feats; j++)
+                sum_feat[j] = 0;
+
+            for(int y = cy * cell_size; y < row_end; y++)
+                for(int x = cx * cell_size; x < col_end; x++)
+                {
+                    float *feats;
+
+                    feats = getNodeFeats(graph, y * graph->num_cols + x, feats_buf);
+
+                    for(int j = 0; j < graph->num_feats; j++)
+                        sum_feat[j] += feats[j];
+                    num_nodes++;
+                }
+
+            for(int j = 0; j < graph->num_feats; j++)
+                cell_feats[(cy * num_cell_cols + cx) * graph->num_feats + j] = sum_feat[j] / num_nodes;
+        }
+    }
+}
+
+static void setDefaultDISFOptions(DISFOptions *opts)
+{
+    opts->queue_engine = HEAP_QUEUE;
+    opts->bucket_step = DEFAULT_BUCKET_STEP;
+    opts->differential = false;
+    opts->num_tiles = 1;
+    opts->seam_width = 0;
+    opts->change_threshold = DEFAULT_CHANGE_THRESHOLD;
+    opts->schedule = EXPONENTIAL_SCHEDULE;
+    opts->schedule_rate = 1;
+    opts->num_stages = 3;
+    opts->schedule_func = NULL;
+    opts->schedule_data = NULL;
+    opts->time_budget = 0;
+    opts->max_iters = 0;
+    opts->progress = NULL;
+    opts->progress_data = NULL;
+    opts->stats = NULL;
+}
+
+static void reserveDISFWorkspace(DISFWorkspace *ws, int num_nodes, int num_seeds, int num_feats, DISFOptions *opts)
+{
+    if(num_nodes > ws->node_capacity)
+    {
+        ws->node_capacity = num_nodes;
+
+        free(ws->nodes); free(ws->is_seed);
+        free(ws->inval_nodes); free(ws->next_in_tree);
+        freeImage(&(ws->label_img));
+        freeIFTQueue(&(ws->queue)); // Both were set over the previous nodes
+        freeTiledIFT(&(ws->tiles));
+
+        ws->nodes = (IFTNode*)calloc(num_nodes, sizeof(IFTNode));
+        ws->is_seed = (bool*)calloc(num_nodes, sizeof(bool));
+        ws->inval_nodes = (int*)calloc(num_nodes, sizeof(int));
+        ws->next_in_tree = (int*)calloc(num_nodes, sizeof(int));
+        ws->label_img = createImage(1, num_nodes, 1);
+    }
+
+    if(ws->queue != NULL && (ws->queue->engine != opts->queue_engine || 
+       (opts->queue_engine == BUCKET_QUEUE && ws->queue->bucket->step != opts->bucket_step)))
+    {
+        freeIFTQueue(&(ws->queue));
+        freeTiledIFT(&(ws->tiles));
+    }
+
+    if(ws->queue == NULL)
+        ws->queue = createIFTQueue(ws->node_capacity, ws->nodes, true, opts);
+
+    if(num_seeds > ws->seed_capacity || num_feats != ws->num_feats)
+    {
+        ws->seed_capacity = MAX(num_seeds, ws->seed_capacity);
+        ws->num_feats = num_feats;
+
+        free(ws->seeds); free(ws->kept_seeds);
+        free(ws->tree_pool); free(ws->tree_feats); free(ws->trees);
+        free(ws->tree_first); free(ws->label_map); free(ws->is_kept);
+        free(ws->tree_prio);
+        freePrioQueue(&(ws->prio_queue));
+        freeRegionAdj(&(ws->tree_adj));
+        freeTiledIFT(&(ws->tiles)); // Its adjacencies are of the previous capacity
+
+        ws->seeds = (int*)calloc(ws->seed_capacity, sizeof(int));
+        ws->kept_seeds = (int*)calloc(ws->seed_capacity, sizeof(int));
+        ws->tree_pool = (Tree*)calloc(ws->seed_capacity, sizeof(Tree));
+        ws->tree_feats = (float*)calloc(2 * ws->seed_capacity * num_feats, sizeof(float));
+        ws->trees = (Tree**)calloc(ws->seed_capacity, sizeof(Tree*));
+        ws->tree_first = (int*)calloc(ws->seed_capacity, sizeof(int));
+        ws->label_map = (int*)calloc(ws->seed_capacity, sizeof(int));
+        ws->is_kept = (bool*)calloc(ws->seed_capacity, sizeof(bool));
+        ws->tree_prio = (double*)calloc(ws->seed_capacity, sizeof(double));
+        ws->prio_queue = createPrioQueue(ws->seed_capacity, ws->tree_prio, MAXVAL_POLICY);
+        ws->tree_adj = createRegionAdj(ws->seed_capacity);
+
+        // As in createTree
+        for(int i = 0; i < ws->seed_capacity; i++)
+        {
+            ws->tree_pool[i].num_feats = num_feats;
+            ws->tree_pool[i].sum_feat = &(ws->tree_feats[2 * i * num_feats]);
+            ws->tree_pool[i].mean_feat = &(ws->tree_pool[i].sum_feat[num_feats]);
+        }
+    }
+}
+
+static void reserveTiledIFT(DISFWorkspace *ws, Graph *graph, DISFOptions *opts)
+{
+    int num_tiles;
+
+    num_tiles = MIN(opts->num_tiles, graph->num_rows);
+
+    if(ws->tiles != NULL && (ws->tiles->num_tiles != num_tiles || ws->tiles->num_cols != graph->num_cols ||
+                             ws->tiles->row_begin[num_tiles] != graph->num_rows))
+        freeTiledIFT(&(ws->tiles));
+
+    if(ws->tiles == NULL)
+        ws->tiles = createTiledIFT(graph, ws->nodes, ws->seed_capacity, opts);
+}
+
+static void resetTree(Tree *tree, int root_index)
+{
+    tree->root_index = root_index;
+    tree->num_nodes = 0;
+
+    for(int i = 0; i < tree->num_feats; i++)
+        tree->sum_feat[i] = tree->mean_feat[i] = 0;
+}
+
+static inline void insertIFTQueue(IFTQueue *queue, int index)
+{
+    queue->num_pushes++;
+
+    if(queue->engine == BUCKET_QUEUE) insertBucketQueue(&(queue->bucket), index);
+    else insertPrioQueue(&(queue->heap), index);
+}
+
+static inline void decreaseIFTQueue(IFTQueue *queue, int index)
+{
+    queue->num_decreases++;
+
+    if(queue->engine == BUCKET_QUEUE) moveIndexBucketQueue(&(queue->bucket), index);
+    else moveIndexUpPrioQueue(&(queue->heap), index);
+}
+
+static inline void resetIFTQueue(IFTQueue *queue)
+{
+    if(queue->engine == BUCKET_QUEUE) resetBucketQueue(&(queue->bucket));
+    else resetPrioQueue(&(queue->heap));
+}
+
+static inline void setIFTQueueState(IFTQueue *queue, int index, ElemState state)
+{
+    queue->stamp[index * queue->stamp_stride] = *(queue->generation) + state;
+}
@@ -0,0 +1,152 @@
+#include "DISFBatch.h"
+
+#include <omp.h>
+
+//=============================================================================
+// Private Prototypes
+//=============================================================================
+// Either imgs or bufs is NULL
+static void runDISFBatchOfInputs(DISFBatch *batch, Image **imgs, ImageBuffer *bufs, int num_imgs, int *n_0, 
+                                 int *n_f, Image **label_imgs, Image **border_imgs);
+
+//=============================================================================
+// Constructors & Deconstructors
+//=============================================================================
+DISFBatch *createDISFBatch(int num_workers, int max_num_rows, int max_num_cols, int max_n_0, DISFOptions *opts)
+{
+    DISFBatch *batch;
+
+    batch = (DISFBatch*)calloc(1, sizeof(DISFBatch));
+
+    if(num_workers > 0) batch->num_workers = num_workers;
+    else batch->num_workers = omp_get_max_threads();
+
+    if(opts != NULL) batch->opts = *opts;
+    else
+    {
+        DISFOptions *default_opts;
+
+        default_opts = createDISFOptions();
+        batch->opts = *default_opts;
+        freeDISFOptions(&default_opts);
+    }
+    batch->opts.num_tiles = 1; // Images are the unit of parallelism
+    batch->opts.stats = NULL; // Its runs are concurrent
+
+    batch->workspaces = (DISFWorkspace**)calloc(batch->num_workers, sizeof(DISFWorkspace*));
+
+    for(int i = 0; i < batch->num_workers; i++)
+        batch->workspaces[i] = createDISFWorkspace(max_num_rows, max_num_cols, max_n_0, &(batch->opts));
+
+    batch->num_imgs = batch->latency_capacity = 0;
+    batch->latency = NULL;
+    batch->total_imgs = 0;
+    batch->total_elapsed = 0;
+
+    return batch;
+}
+
+void freeDISFBatch(DISFBatch **batch)
+{
+    if(*batch != NULL)
+    {
+        DISFBatch *tmp;
+
+        tmp = *batch;
+
+        for(int i = 0; i < tmp->num_workers; i++)
+            freeDISFWorkspace(&(tmp->workspaces[i]));
+
+        free(tmp->workspaces);
+        free(tmp->latency);
+        free(tmp);
+
+        *batch = NULL;
+    }
+}
+
+//=============================================================================
+// Void
+//=============================================================================
+void runDISFBatch(DISFBatch *batch, Image **imgs, int num_imgs, int *n_0, int *n_f,
+                  Image **label_imgs, Image **border_imgs)
+{
+    runDISFBatchOfInputs(batch, imgs, NULL, num_imgs, n_0, n_f, label_imgs, border_imgs);
+}
+
+void runDISFBatchFromBuffers(DISFBatch *batch, ImageBuffer *bufs, int num_imgs, int *n_0, int *n_f,
+                             Image **label_imgs, Image **border_imgs)
+{
+    runDISFBatchOfInputs(batch, NULL, bufs, num_imgs, n_0, n_f, label_imgs, border_imgs);
+}
+
+static void runDISFBatchOfInputs(DISFBatch *batch, Image **imgs, ImageBuffer *bufs, int num_imgs, int *n_0, 
+                                 int *n_f, Image **label_imgs, Image **border_imgs)
+{
+    double start;
+
+    if(num_imgs > batch->latency_capacity)
+    {
+        free(batch->latency);
+
+        batch->latency_capacity = num_imgs;
+        batch->latency = (double*)calloc(num_imgs, sizeof(double));
+    }
+
+    start = omp_get_wtime();
+
+    #pragma omp parallel num_threads(batch->num_workers)
+    {
+        DISFWorkspace *ws;
+
+        ws = batch->workspaces[omp_get_thread_num()];
+
+        // Only affects this worker's nested regions
+        omp_set_num_threads(1);
+
+        #pragma omp for schedule(dynamic)
+        for(int i = 0; i < num_imgs; i++)
+        {
+            double img_start;
+            Graph *graph;
+            Image *label_img;
+
+            img_start = omp_get_wtime();
+
+            if(imgs != NULL) graph = createGraph(imgs[i]);
+            else
+                graph = createGraphFromBuffer(bufs[i].data, bufs[i].type, bufs[i].num_rows, bufs[i].num_cols, 
+                                              bufs[i].num_channels, bufs[i].row_stride, bufs[i].pixel_stride, 
+                                              bufs[i].channel_stride);
+
+            if(border_imgs != NULL)
+                border_imgs[i] = createImageOfType(graph->num_rows, graph->num_cols, 1, UINT8_TYPE);
+
+            label_img = runDISFWithWorkspace(ws, graph, n_0[i], n_f[i],
+                                             border_imgs != NULL ? &(border_imgs[i]) : NULL, &(batch->opts));
+
+            // The workspace's label image is overwritten by its next image
+            label_imgs[i] = createImage(graph->num_rows, graph->num_cols, 1);
+            memcpy(label_imgs[i]->val.i32, label_img->val.i32, (size_t)graph->num_nodes * sizeof(int));
+
+            freeGraph(&graph);
+
+            batch->latency[i] = omp_get_wtime() - img_start;
+        }
+    }
+
+    batch->num_imgs = num_imgs;
+    batch->elapsed = omp_get_wtime() - start;
+    batch->throughput = batch->elapsed > 0 ? num_imgs / batch->elapsed : 0;
+
+    batch->mean_latency = batch->max_latency = 0;
+    for(int i = 0; i < num_imgs; i++)
+    {
+        batch->mean_latency += batch->latency[i];
+        batch->max_latency = MAX(batch->max_latency, batch->latency[i]);
+    }
+    if(num_imgs > 0) batch->mean_latency /= num_imgs;
+
+    batch->total_imgs += num_imgs;
+    batch->total_elapsed += batch->elapsed;
+}
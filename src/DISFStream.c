@@ -0,0 +1,427 @@
+#include "DISFStream.h"
+
+//=============================================================================
+// Prototypes
+//=============================================================================
+// Segments the buffered rows, and commits band_rows of them (or all, if last)
+static void processDISFStreamBand(DISFStream *stream, bool last);
+// Carries the committed rows' features and the last one's roots into the pinned trees. The
+// components must be those of commitDISFStreamRows
+static void carryDISFStreamTrees(DISFStream *stream, Graph *graph, int num_pinned, int last_row);
+// Relabels the components of the committed rows into the emission window
+static void commitDISFStreamRows(DISFStream *stream, Image *label_img, int num_pinned, int row_begin, int row_end);
+// Writes the held rows, but the last one (unless last, i.e., no row follows)
+static void emitDISFStreamRows(DISFStream *stream, bool last);
+
+//=============================================================================
+// Constructors & Deconstructors
+//=============================================================================
+DISFStream *createDISFStream(int num_rows, int num_cols, int num_channels, int n_0, int n_f,
+                             int band_rows, int overlap_rows, DISFOptions *opts,
+                             DISFStreamWriter writer, void *user_data)
+{
+    int side, band_nodes, band_n_0;
+    DISFStream *stream;
+
+    if(num_rows < 1 || num_cols < 1)
+        printError("createDISFStream", "Invalid image size <%d,%d>", num_rows, num_cols);
+    else if(n_0 < n_f || n_f < 1)
+        printError("createDISFStream", "N0 must be >> Nf >= 1");
+    else if(writer == NULL)
+        printError("createDISFStream", "A writer is required");
+
+    stream = (DISFStream*)calloc(1, sizeof(DISFStream));
+
+    stream->num_rows = num_rows;
+    stream->num_cols = num_cols;
+    stream->num_channels = num_channels;
+    stream->n_0 = n_0;
+    stream->n_f = n_f;
+    stream->writer = writer;
+    stream->user_data = user_data;
+
+    if(opts != NULL) stream->opts = *opts;
+    else
+    {
+        DISFOptions *default_opts;
+
+        default_opts = createDISFOptions();
+        stream->opts = *default_opts;
+        freeDISFOptions(&default_opts);
+    }
+    stream->opts.differential = false;
+    stream->opts.num_tiles = 1;
+
+    // Approximate superpixel side, at the end
+    side = MAX((int)ceil(sqrt(num_rows * (double)num_cols / n_f)), 1);
+
+    // Narrower bands than a couple of superpixels would split most of them
+    if(band_rows > 0) stream->band_rows = MAX(band_rows, 2 * side);
+    else stream->band_rows = MAX(4 * side, 64);
+    if(overlap_rows >= 0) stream->overlap_rows = overlap_rows;
+    else stream->overlap_rows = side;
+
+    stream->band_rows = MIN(stream->band_rows, num_rows);
+    stream->overlap_rows = MIN(stream->overlap_rows, num_rows - stream->band_rows);
+
+    stream->buf_capacity = 1 + stream->band_rows + stream->overlap_rows;
+    band_nodes = stream->buf_capacity * num_cols;
+    band_n_0 = (int)ceil(n_0 * (band_nodes / (num_rows * (double)num_cols)));
+
+    stream->buf_feats = (float*)calloc((size_t)band_nodes * 3, sizeof(float));
+    stream->ws = createDISFWorkspace(stream->buf_capacity, num_cols, band_n_0, &(stream->opts));
+
+    // A pinned tree per column, at most
+    stream->pinned.num_feats = 3;
+    stream->pinned.sum_feat = (float*)calloc((size_t)num_cols * 3, sizeof(float));
+    stream->pinned.num_nodes = (int*)calloc(num_cols, sizeof(int));
+    stream->pinned.root_nodes = (int*)calloc(num_cols, sizeof(int));
+    stream->pinned.root_labels = (int*)calloc(num_cols, sizeof(int));
+    stream->pinned_labels = (int*)calloc(num_cols, sizeof(int));
+    stream->next_sum_feat = (float*)calloc((size_t)num_cols * 3, sizeof(float));
+    stream->next_num_nodes = (int*)calloc(num_cols, sizeof(int));
+    stream->next_pinned_labels = (int*)calloc(num_cols, sizeof(int));
+
+    for(int i = 0; i < num_cols; i++)
+        stream->pinned.root_nodes[i] = i; // The band's first row
+
+    // A component per node, at most
+    stream->comp_map = (int*)calloc(band_nodes, sizeof(int));
+    stream->comp_queue = (int*)calloc(band_nodes, sizeof(int));
+    stream->comp_keys = (int*)calloc(band_nodes, sizeof(int));
+    stream->comp_labels = (int*)calloc(band_nodes, sizeof(int));
+    // Besides a pinned tree per column
+    stream->pinned_map = (int*)calloc(band_nodes + num_cols, sizeof(int));
+    stream->band_num_nodes = (int*)calloc(band_nodes + num_cols, sizeof(int));
+    stream->band_sum_feat = (float*)calloc((size_t)(band_nodes + num_cols) * 3, sizeof(float));
+
+    stream->out_labels = (int*)calloc((size_t)(stream->buf_capacity + 1) * num_cols, sizeof(int));
+    stream->out_borders = (unsigned char*)calloc((size_t)stream->buf_capacity * num_cols, sizeof(unsigned char));
+
+    return stream;
+}
+
+void freeDISFStream(DISFStream **stream)
+{
+    if(*stream != NULL)
+    {
+        DISFStream *tmp;
+
+        tmp = *stream;
+
+        freeDISFWorkspace(&(tmp->ws));
+
+        free(tmp->buf_feats);
+        free(tmp->pinned.sum_feat);
+        free(tmp->pinned.num_nodes);
+        free(tmp->pinned.root_nodes);
+        free(tmp->pinned.root_labels);
+        free(tmp->pinned_labels);
+        free(tmp->next_sum_feat);
+        free(tmp->next_num_nodes);
+        free(tmp->next_pinned_labels);
+        free(tmp->comp_map);
+        free(tmp->comp_queue);
+        free(tmp->comp_keys);
+        free(tmp->comp_labels);
+        free(tmp->pinned_map);
+        free(tmp->band_num_nodes);
+        free(tmp->band_sum_feat);
+        free(tmp->out_labels);
+        free(tmp->out_borders);
+        free(tmp);
+
+        *stream = NULL;
+    }
+}
+
+//=============================================================================
+// Void
+//=============================================================================
+void pushDISFStreamRows(DISFStream *stream, Image *img)
+{
+    int normval;
+    size_t pixel_size;
+    const float *gamma_lut;
+
+    if(img->num_cols != stream->num_cols || img->num_channels != stream->num_channels)
+        printError("pushDISFStreamRows", "The rows do not match the stream's width and channels");
+    else if(stream->num_pushed + img->num_rows > stream->num_rows)
+        printError("pushDISFStreamRows", "More rows than the image's were pushed");
+
+    if(img->type == UINT8_TYPE) normval = 255;
+    else normval = 65535;
+
+    pixel_size = getPixelTypeSize(img->type) * img->num_channels;
+    gamma_lut = getsRGBGammaLUT(normval);
+
+    for(int y = 0; y < img->num_rows; y++)
+    {
+        float *row_feats;
+
+        row_feats = &(stream->buf_feats[(size_t)stream->num_buf_rows * stream->num_cols * 3]);
+
+        convertRowToLab((char*)img->val.raw + (size_t)y * img->num_cols * pixel_size, img->type, img->num_channels,
+                        img->num_cols, normval, gamma_lut, row_feats, 3, 1);
+
+        stream->num_buf_rows++;
+        stream->num_pushed++;
+
+        if(stream->num_buf_rows == (stream->has_pinned ? 1 : 0) + stream->band_rows + stream->overlap_rows)
+            processDISFStreamBand(stream, false);
+    }
+}
+
+void finishDISFStream(DISFStream *stream)
+{
+    if(stream->num_pushed != stream->num_rows)
+        printError("finishDISFStream", "Only %d of %d rows were pushed", stream->num_pushed, stream->num_rows);
+
+    processDISFStreamBand(stream, true);
+}
+
+static void processDISFStreamBand(DISFStream *stream, bool last)
+{
+    int first_row, commit_end, num_pinned, band_n_0, band_n_f;
+    double band_ratio;
+    Graph graph;
+    Image *label_img;
+
+    first_row = stream->has_pinned ? 1 : 0;
+    num_pinned = stream->has_pinned ? stream->pinned.num_trees : 0;
+
+    if(stream->num_buf_rows == first_row) // Only the pinned row, already committed
+    {
+        emitDISFStreamRows(stream, last);
+        return;
+    }
+
+    graph.num_rows = stream->num_buf_rows;
+    graph.num_cols = stream->num_cols;
+    graph.num_nodes = graph.num_rows * graph.num_cols;
+    graph.num_feats = 3;
+    graph.layout = INTERLEAVED_LAYOUT;
+    graph.feats = stream->buf_feats;
+
+    // The same densities of the whole image
+    band_ratio = graph.num_nodes / (stream->num_rows * (double)stream->num_cols);
+    band_n_0 = MAX((int)round(stream->n_0 * band_ratio), 1);
+    band_n_f = MIN(MAX((int)round(stream->n_f * band_ratio), 1), band_n_0);
+
+    stream->pinned.num_trees = num_pinned;
+    stream->pinned.num_roots = stream->has_pinned ? stream->num_cols : 0;
+
+    label_img = runDISFWithPinnedTrees(stream->ws, &graph, band_n_0, band_n_f, NULL, &(stream->opts), &(stream->pinned));
+
+    if(last) commit_end = stream->num_buf_rows;
+    else commit_end = first_row + stream->band_rows;
+
+    commitDISFStreamRows(stream, label_img, num_pinned, first_row, commit_end);
+
+    if(!last)
+    {
+        carryDISFStreamTrees(stream, &graph, num_pinned, commit_end - 1);
+
+        // The last committed row is pinned, followed by the lookahead
+        stream->num_buf_rows -= commit_end - 1;
+        memmove(stream->buf_feats, &(stream->buf_feats[(size_t)(commit_end - 1) * stream->num_cols * 3]),
+                (size_t)stream->num_buf_rows * stream->num_cols * 3 * sizeof(float));
+        stream->has_pinned = true;
+    }
+
+    emitDISFStreamRows(stream, last);
+}
+
+static void commitDISFStreamRows(DISFStream *stream, Image *label_img, int num_pinned, int row_begin, int row_end)
+{
+    int num_cols, num_comps, *held_labels;
+
+    num_cols = stream->num_cols;
+    held_labels = &(stream->out_labels[(size_t)(1 + stream->num_held) * num_cols]);
+
+    for(int i = 0; i < row_end * num_cols; i++)
+        stream->comp_map[i] = -1;
+
+    // A tree may only be connected through the lookahead, thus each of its components (within
+    // the committed rows and the pinned one) is labeled by its first appearance, unless pinned
+    num_comps = 0;
+    for(int i = 0; i < row_end * num_cols; i++)
+    {
+        int label, num_queued, comp;
+
+        if(stream->comp_map[i] != -1) continue;
+
+        label = label_img->val.i32[i];
+        comp = num_comps++;
+
+        if(i < row_begin * num_cols) // Connected to the previous bands by its pinned roots
+        {
+            stream->comp_keys[comp] = label;
+            stream->comp_labels[comp] = stream->pinned_labels[label];
+        }
+        else
+        {
+            stream->comp_keys[comp] = num_pinned + comp;
+            stream->comp_labels[comp] = stream->num_labels++;
+        }
+
+        stream->comp_map[i] = comp;
+        stream->comp_queue[0] = i;
+        num_queued = 1;
+
+        for(int j = 0; j < num_queued; j++)
+        {
+            int index, x, y;
+
+            index = stream->comp_queue[j];
+            x = index % num_cols;
+            y = index / num_cols;
+
+            for(int adj_y = MAX(y - 1, 0); adj_y <= MIN(y + 1, row_end - 1); adj_y++)
+                for(int adj_x = MAX(x - 1, 0); adj_x <= MIN(x + 1, num_cols - 1); adj_x++)
+                {
+                    int adj_index;
+
+                    adj_index = adj_y * num_cols + adj_x;
+
+                    if(stream->comp_map[adj_index] == -1 && label_img->val.i32[adj_index] == label)
+                    {
+                        stream->comp_map[adj_index] = comp;
+                        stream->comp_queue[num_queued++] = adj_index;
+                    }
+                }
+        }
+    }
+
+    for(int i = row_begin * num_cols; i < row_end * num_cols; i++)
+        held_labels[i - row_begin * num_cols] = stream->comp_labels[stream->comp_map[i]];
+
+    stream->num_held += row_end - row_begin;
+}
+
+static void carryDISFStreamTrees(DISFStream *stream, Graph *graph, int num_pinned, int last_row)
+{
+    int num_cols, num_keys, num_next, *tmp_labels, *tmp_num_nodes;
+    float *tmp_sum_feat;
+
+    num_cols = stream->num_cols;
+    num_keys = num_pinned + last_row * num_cols + num_cols; // Pinned trees, and components at most
+
+    for(int i = 0; i < num_keys; i++)
+    {
+        stream->band_num_nodes[i] = 0;
+        stream->pinned_map[i] = -1;
+    }
+    memset(stream->band_sum_feat, 0, (size_t)num_keys * 3 * sizeof(float));
+
+    // Nodes above the next pinned row, by pinned tree or new component
+    for(int i = 0; i < last_row * num_cols; i++)
+    {
+        int key;
+
+        key = stream->comp_keys[stream->comp_map[i]];
+
+        stream->band_num_nodes[key]++;
+        for(int j = 0; j < 3; j++)
+            stream->band_sum_feat[key * 3 + j] += graph->feats[i * 3 + j];
+    }
+
+    num_next = 0;
+
+    for(int i = last_row * num_cols; i < (last_row + 1) * num_cols; i++)
+    {
+        int key, id;
+
+        key = stream->comp_keys[stream->comp_map[i]];
+
+        if(stream->pinned_map[key] == -1)
+        {
+            id = stream->pinned_map[key] = num_next++;
+
+            stream->next_pinned_labels[id] = stream->comp_labels[stream->comp_map[i]];
+            stream->next_num_nodes[id] = stream->band_num_nodes[key];
+            for(int j = 0; j < 3; j++)
+                stream->next_sum_feat[id * 3 + j] = stream->band_sum_feat[key * 3 + j];
+
+            // Nodes of the previous bands
+            if(key < num_pinned)
+            {
+                stream->next_num_nodes[id] += stream->pinned.num_nodes[key];
+                for(int j = 0; j < 3; j++)
+                    stream->next_sum_feat[id * 3 + j] += stream->pinned.sum_feat[key * 3 + j];
+            }
+        }
+
+        // Only read by the next band
+        stream->pinned.root_labels[i - last_row * num_cols] = stream->pinned_map[key];
+    }
+
+    tmp_labels = stream->pinned_labels;
+    stream->pinned_labels = stream->next_pinned_labels;
+    stream->next_pinned_labels = tmp_labels;
+
+    tmp_num_nodes = stream->pinned.num_nodes;
+    stream->pinned.num_nodes = stream->next_num_nodes;
+    stream->next_num_nodes = tmp_num_nodes;
+
+    tmp_sum_feat = stream->pinned.sum_feat;
+    stream->pinned.sum_feat = stream->next_sum_feat;
+    stream->next_sum_feat = tmp_sum_feat;
+
+    stream->pinned.num_trees = num_next;
+}
+
+static void emitDISFStreamRows(DISFStream *stream, bool last)
+{
+    int num_cols, num_emit, *labels;
+
+    num_cols = stream->num_cols;
+    num_emit = last ? stream->num_held : stream->num_held - 1;
+
+    if(num_emit <= 0) return;
+
+    labels = stream->out_labels; // Row 0 is the last emitted one, if any
+
+    #pragma omp parallel for
+    for(int y = 1; y <= num_emit; y++)
+    {
+        for(int x = 0; x < num_cols; x++)
+        {
+            bool is_border;
+            int label;
+
+            is_border = false;
+            label = labels[y * num_cols + x];
+
+            for(int dy = -1; dy <= 1 && !is_border; dy++)
+            {
+                int adj_y;
+
+                adj_y = y + dy;
+
+                if((adj_y == 0 && stream->num_emitted == 0) || adj_y > stream->num_held)
+                    continue; // Outside the image
+
+                for(int dx = -1; dx <= 1 && !is_border; dx++)
+                {
+                    int adj_x;
+
+                    adj_x = x + dx;
+
+                    if(adj_x >= 0 && adj_x < num_cols)
+                        is_border = labels[adj_y * num_cols + adj_x] != label;
+                }
+            }
+
+            stream->out_borders[(y - 1) * num_cols + x] = is_border ? 255 : 0;
+        }
+    }
+
+    stream->writer(stream->num_emitted, num_emit, num_cols, &(labels[num_cols]), stream->out_borders, stream->user_data);
+
+    stream->num_emitted += num_emit;
+    stream->num_held -= num_emit;
+
+    // Keeps the last emitted row, and the held ones
+    memmove(labels, &(labels[(size_t)num_emit * num_cols]), (size_t)(1 + stream->num_held) * num_cols * sizeof(int));
+}
@@ -4,6 +4,11 @@
 // Constructors & Deconstructors
 //=============================================================================
 Image *createImage(int num_rows, int num_cols, int num_channels)
+{
+    return createImageOfType(num_rows, num_cols, num_channels, INT32_TYPE);
+}
+
+Image *createImageOfType(int num_rows, int num_cols, int num_channels, PixelType type)
 {
     Image *new_img;
 
@@ -13,11 +18,10 @@ Image *createImage(int num_rows, int num_cols, int num_channels)
     new_img->num_cols = num_cols;
     new_img->num_pixels = num_rows * num_cols;
     new_img->num_channels = num_channels;
+    new_img->type = type;
 
-    new_img->val = (int**)calloc(new_img->num_pixels, sizeof(int*));
-    #pragma omp parallel for
-    for(int i = 0; i < new_img->num_pixels; i++)
-        new_img->val[i] = (int*)calloc(num_channels, sizeof(int));
+    new_img->val.raw = callocAligned((size_t)new_img->num_pixels * num_channels, 
+                                     getPixelTypeSize(type));
 
     return new_img;
 }
@@ -30,10 +34,7 @@ void freeImage(Image **img)
 
         tmp = *img;
 
-        for(int i = 0; i < tmp->num_pixels; i++)
-            free(tmp->val[i]);
-        free(tmp->val);
-
+        free(tmp->val.raw);
         free(tmp);
 
         *img = NULL;
@@ -43,6 +44,21 @@ void freeImage(Image **img)
 //=============================================================================
 // Int
 //=============================================================================
+inline int getImageVal(Image *img, int index, int channel)
+{
+    int pos;
+
+    pos = index * img->num_channels + channel;
+
+    switch(img->type)
+    {
+        case UINT8_TYPE: return img->val.u8[pos];
+        case UINT16_TYPE: return img->val.u16[pos];
+        case FLOAT32_TYPE: return (int)img->val.f32[pos];
+        default: return img->val.i32[pos];
+    }
+}
+
 int getMaximumValue(Image *img, int channel)
 {
     int max_val, chn_begin, chn_end;
@@ -57,8 +73,8 @@ int getMaximumValue(Image *img, int channel)
 
     for(int i = 0; i < img->num_pixels; i++)
         for(int j = chn_begin; j <= chn_end; j++)
-            if(max_val < img->val[i][j])
-                max_val = img->val[i][j];
+            if(max_val < getImageVal(img, i, j))
+                max_val = getImageVal(img, i, j);
 
     return max_val;   
 }
@@ -77,8 +93,8 @@ int getMinimumValue(Image *img, int channel)
 
     for(int i = 0; i < img->num_pixels; i++)
         for(int j = chn_begin; j <= chn_end; j++)
-            if(min_val == -1 || min_val > img->val[i][j])
-                min_val = img->val[i][j];
+            if(min_val == -1 || min_val > getImageVal(img, i, j))
+                min_val = getImageVal(img, i, j);
 
     return min_val;   
 }
@@ -87,6 +103,9 @@ int getNormValue(Image *img)
 {
     int max_val;
 
+    if(img->type == UINT8_TYPE) return 255; // No need to scan
+    if(img->type == FLOAT32_TYPE) return 1; // Already normalized
+
     max_val = getMaximumValue(img, -1);
 
     if(max_val > 65535)
@@ -94,4 +113,36 @@ int getNormValue(Image *img)
 
     if(max_val <= 255) return 255;
     else return 65535;
-}
\ No newline at end of file
+}
+
+//=============================================================================
+// Size_t
+//=============================================================================
+inline size_t getPixelTypeSize(PixelType type)
+{
+    switch(type)
+    {
+        case UINT8_TYPE: return sizeof(unsigned char);
+        case UINT16_TYPE: return sizeof(unsigned short);
+        case FLOAT32_TYPE: return sizeof(float);
+        default: return sizeof(int);
+    }
+}
+
+//=============================================================================
+// Void
+//=============================================================================
+inline void setImageVal(Image *img, int index, int channel, int value)
+{
+    int pos;
+
+    pos = index * img->num_channels + channel;
+
+    switch(img->type)
+    {
+        case UINT8_TYPE: img->val.u8[pos] = (unsigned char)value; break;
+        case UINT16_TYPE: img->val.u16[pos] = (unsigned short)value; break;
+        case FLOAT32_TYPE: img->val.f32[pos] = (float)value; break;
+        default: img->val.i32[pos] = value;
+    }
+}
@@ -1,9 +1,45 @@
 #include "PrioQueue.h"
 
+//=============================================================================
+// Private Prototypes
+//=============================================================================
+// If stamp is NULL, the queue allocates its own stamps
+static PrioQueue* createPrioQueueOfStride(int size, double *prio, int prio_stride, unsigned int *stamp, 
+                                          int stamp_stride, RemPolicy rem_policy, int arity);
+
+static double getHeapKey(PrioQueue *queue, int index); // Of its current priority
+// Places elem at pos, or above it, by moving its ancestors down
+static void siftUpPrioQueue(PrioQueue *queue, int pos, HeapElem elem);
+// Places elem at pos, or below it, by moving its descendants up
+static void siftDownPrioQueue(PrioQueue *queue, int pos, HeapElem elem);
+
 //=============================================================================
 // Constructors & Deconstructors
 //=============================================================================
 PrioQueue* createPrioQueue(int size, double *prio, RemPolicy rem_policy)
+{
+    return createPrioQueueWithArity(size, prio, rem_policy, PRIOQUEUE_ARITY);
+}
+
+PrioQueue* createPrioQueueWithArity(int size, double *prio, RemPolicy rem_policy, int arity)
+{
+    if(arity < 2 || arity > MAX_PRIOQUEUE_ARITY || (arity & (arity - 1)) != 0)
+        printError("createPrioQueueWithArity", "The arity must be a power of 2 within [2,%d]", MAX_PRIOQUEUE_ARITY);
+
+    return createPrioQueueOfStride(size, prio, 1, NULL, 1, rem_policy, arity);
+}
+
+PrioQueue* createPrioQueueOfRecords(int size, double *prio, int prio_stride, unsigned int *stamp, int stamp_stride,
+                                    RemPolicy rem_policy)
+{
+    if(prio_stride < 1 || stamp_stride < 1)
+        printError("createPrioQueueOfRecords", "The strides must be positive");
+
+    return createPrioQueueOfStride(size, prio, prio_stride, stamp, stamp_stride, rem_policy, PRIOQUEUE_ARITY);
+}
+
+static PrioQueue* createPrioQueueOfStride(int size, double *prio, int prio_stride, unsigned int *stamp, 
+                                          int stamp_stride, RemPolicy rem_policy, int arity)
 {
     PrioQueue *queue;
 
@@ -11,18 +47,30 @@ PrioQueue* createPrioQueue(int size, double *prio, RemPolicy rem_policy)
 
     queue->size = size;
     queue->prio = prio;
-    queue->state = (ElemState*)calloc(size, sizeof(ElemState));
-    queue->node = (int*)calloc(size, sizeof(int));
+    queue->prio_stride = prio_stride;
+    queue->arity = arity;
+    queue->owns_stamp = stamp == NULL;
+    queue->stamp_stride = stamp_stride;
+    queue->generation = 0;
+
+    if(queue->owns_stamp)
+        queue->stamp = (unsigned int*)calloc(size, sizeof(unsigned int)); // WHITE_STATE of generation 0
+    else
+    {
+        queue->stamp = stamp;
+
+        for(int i = 0; i < size; i++)
+            queue->stamp[i * stamp_stride] = 0;
+    }
+
     queue->pos = (int*)calloc(size, sizeof(int));
+    queue->heap = (HeapElem*)callocAligned(size + arity - 1, sizeof(HeapElem)) + arity - 1;
     queue->last_elem_pos = -1;
     queue->rem_policy = rem_policy;
 
-    for(int i = 0; i < queue->size; i++)
-    {
-        queue->state[i] = WHITE_STATE;
-        queue->pos[i] = -1;
-        queue->node[i] = -1;
-    }
+    queue->arity_log2 = 0;
+    while((1 << queue->arity_log2) < arity)
+        queue->arity_log2++;
 
     return queue;
 }
@@ -35,10 +83,12 @@ void freePrioQueue(PrioQueue **queue)
 
         tmp = *queue;
 
-        free(tmp->state);
-        free(tmp->node);
+        if(tmp->owns_stamp) free(tmp->stamp);
         free(tmp->pos);
+        free(tmp->heap - (tmp->arity - 1));
         free(*queue);
+
+        *queue = NULL;
     }
 }
 //=============================================================================
@@ -48,7 +98,7 @@ bool insertPrioQueue(PrioQueue **queue, int index)
 {
     bool success;
 
-    if(isPrioQueueFull(*queue)) 
+    if(isPrioQueueFull(*queue))
     {
         printWarning("insertPrioQueue", "The queue is full");
         success = false;
@@ -56,16 +106,17 @@ bool insertPrioQueue(PrioQueue **queue, int index)
     else
     {
         PrioQueue *tmp;
+        HeapElem elem;
 
         tmp = *queue;
 
         tmp->last_elem_pos++;
-        
-        tmp->node[tmp->last_elem_pos] = index;
-        tmp->state[index] = GRAY_STATE; // Newly inserted
-        tmp->pos[index] = tmp->last_elem_pos;
+        tmp->stamp[index * tmp->stamp_stride] = tmp->generation + GRAY_STATE; // Newly inserted
+
+        elem.key = getHeapKey(tmp, index);
+        elem.index = index;
 
-        moveIndexUpPrioQueue(queue, index);
+        siftUpPrioQueue(tmp, tmp->last_elem_pos, elem);
         success = true;
     }
 
@@ -85,26 +136,21 @@ inline bool isPrioQueueFull(PrioQueue *queue)
 //=============================================================================
 // Int
 //=============================================================================
-inline int getFatherPos(int pos)
+inline int getFatherPos(PrioQueue *queue, int pos)
 {
-    return (pos - 1)/2; 
+    return (pos - 1) >> queue->arity_log2;
 }
 
-inline int getLeftSonPos(int pos)
+inline int getFirstSonPos(PrioQueue *queue, int pos)
 {
-    return (2 * pos + 1); 
-}
-
-inline int getRightSonPos(int pos)
-{
-    return (2 * pos + 2); 
+    return (pos << queue->arity_log2) + 1;
 }
 
 int popPrioQueue(PrioQueue **queue)
-{    
+{
     int index;
-    
-    if(isPrioQueueEmpty(*queue)) 
+
+    if(isPrioQueueEmpty(*queue))
     {
         printWarning("popPrioQueue", "The queue is empty");
         index = -1;
@@ -115,188 +161,185 @@ int popPrioQueue(PrioQueue **queue)
 
         tmp = *queue;
 
-        index = tmp->node[0]; // Aux
+        index = tmp->heap[0].index; // Aux
 
-        tmp->pos[index] = -1;
-        tmp->state[index] = BLACK_STATE; // Ordely removed
+        tmp->stamp[index * tmp->stamp_stride] = tmp->generation + BLACK_STATE; // Ordely removed
 
-        // Puts in first and removes the last
-        tmp->node[0] = tmp->node[tmp->last_elem_pos];
-        tmp->pos[tmp->node[0]] = 0;
-        tmp->node[tmp->last_elem_pos] = -1;
-        
+        // The last fills the hole at the first
         tmp->last_elem_pos--;
 
-        moveIndexDownPrioQueue(queue, tmp->node[0]);
+        if(tmp->last_elem_pos >= 0)
+            siftDownPrioQueue(tmp, 0, tmp->heap[tmp->last_elem_pos + 1]);
     }
 
     return index;
 }
 
+//=============================================================================
+// ElemState
+//=============================================================================
+inline ElemState getPrioQueueState(PrioQueue *queue, int index)
+{
+    unsigned int stamp;
+
+    stamp = queue->stamp[index * queue->stamp_stride];
+
+    // Every element of a past generation is WHITE_STATE
+    return stamp >= queue->generation ? (ElemState)(stamp - queue->generation) : WHITE_STATE;
+}
+
+//=============================================================================
+// Double
+//=============================================================================
+static inline double getHeapKey(PrioQueue *queue, int index)
+{
+    double prio;
+
+    prio = queue->prio[index * queue->prio_stride];
+
+    return queue->rem_policy == MINVAL_POLICY ? prio : -prio;
+}
+
 //=============================================================================
 // Void
 //=============================================================================
 void moveIndexDownPrioQueue(PrioQueue **queue, int index)
-{    
-    int pos, curr_pos, left_pos, right_pos, curr_index;
-    float curr_prio;
+{
     PrioQueue *tmp;
 
     tmp = *queue;
 
-    if(index < tmp->size && index >= 0) 
+    if(index < tmp->size && index >= 0 && getPrioQueueState(tmp, index) == GRAY_STATE)
     {
-        pos = tmp->pos[index]; // Aux
+        HeapElem elem;
 
-        left_pos = getLeftSonPos(pos);
-        right_pos = getRightSonPos(pos);
+        elem.key = getHeapKey(tmp, index);
+        elem.index = index;
 
-        curr_pos = pos;
-        curr_index = index;
-        curr_prio = tmp->prio[curr_index];
+        siftDownPrioQueue(tmp, tmp->pos[index], elem);
+    }
+}
 
-        if(left_pos <= tmp->last_elem_pos)
-        {
-            int left_index;
-            float left_prio;
-
-            left_index = tmp->node[left_pos];
-            left_prio = tmp->prio[left_index];
-
-            if((tmp->rem_policy == MINVAL_POLICY && left_prio < curr_prio) ||
-               (tmp->rem_policy == MAXVAL_POLICY && left_prio > curr_prio))
-            {
-                curr_pos = left_pos;
-                curr_index = left_index;
-                curr_prio = left_prio;
-            }
-            else if(left_prio == curr_prio)
-            {
-                curr_pos = left_pos;
-                curr_index = left_index;
-                curr_prio = left_prio;
-            }
-        }
+void moveIndexUpPrioQueue(PrioQueue **queue, int index)
+{
+    PrioQueue *tmp;
 
-        if(right_pos <= tmp->last_elem_pos)
-        {
-            int right_index;
-            float right_prio;
-
-            right_index = tmp->node[right_pos];
-            right_prio = tmp->prio[right_index];
-
-            if((tmp->rem_policy == MINVAL_POLICY && right_prio < curr_prio) ||
-               (tmp->rem_policy == MAXVAL_POLICY && right_prio > curr_prio))
-            {
-                curr_pos = right_pos;
-                curr_index = right_index;
-                curr_prio = right_prio;
-            }
-            else if(right_prio == curr_prio)
-            {
-                curr_pos = right_pos;
-                curr_index = right_index;
-                curr_prio = right_prio;
-            }
-        }
+    tmp = *queue;
 
-        if(curr_pos != pos)
-        {
-            tmp->node[curr_pos] = index;
-            tmp->pos[curr_index] = pos;
+    if(index < tmp->size && index >= 0 && getPrioQueueState(tmp, index) == GRAY_STATE)
+    {
+        HeapElem elem;
 
-            tmp->node[pos] = curr_index;
-            tmp->pos[index] = curr_pos;
+        elem.key = getHeapKey(tmp, index);
+        elem.index = index;
 
-            moveIndexDownPrioQueue(queue, index);
-        }
+        siftUpPrioQueue(tmp, tmp->pos[index], elem);
     }
 }
 
-void moveIndexUpPrioQueue(PrioQueue **queue, int index)
+void removePrioQueueElem(PrioQueue **queue, int index)
 {
-    int pos, curr_pos, curr_index, father_pos;
-    float prio, curr_prio;
+    int pos;
     PrioQueue *tmp;
 
     tmp = *queue;
 
-    if(index < tmp->size && index >= 0) 
-    {
-        // Aux
-        pos = tmp->pos[index];
-        prio = tmp->prio[index];
+    pos = tmp->pos[index];
 
-        father_pos = getFatherPos(pos);
+    tmp->stamp[index * tmp->stamp_stride] = tmp->generation + WHITE_STATE; // Non-ordely removed
 
-        curr_pos = pos;
-        curr_index = index;
-        curr_prio = prio;
+    // The last fills the hole, in either direction
+    tmp->last_elem_pos--;
 
-        if(father_pos >= 0)
-        {
-            int father_index;
-            float father_prio;
-
-            father_index = tmp->node[father_pos];
-            father_prio = tmp->prio[father_index];
-
-            if((tmp->rem_policy == MINVAL_POLICY && father_prio > curr_prio) ||
-               (tmp->rem_policy == MAXVAL_POLICY && father_prio < curr_prio))
-            {
-                curr_pos = father_pos;
-                curr_index = father_index;
-                curr_prio = father_prio;
-            }
-        }
-
-        if(curr_pos != pos)
-        {
-            tmp->node[curr_pos] = index;
-            tmp->pos[curr_index] = pos;
+    if(pos <= tmp->last_elem_pos)
+    {
+        HeapElem last_elem;
 
-            tmp->node[pos] = curr_index;
-            tmp->pos[index] = curr_pos;
+        last_elem = tmp->heap[tmp->last_elem_pos + 1];
 
-            moveIndexUpPrioQueue(queue, index);
-        }
+        if(pos > 0 && tmp->heap[getFatherPos(tmp, pos)].key > last_elem.key)
+            siftUpPrioQueue(tmp, pos, last_elem);
+        else
+            siftDownPrioQueue(tmp, pos, last_elem);
     }
 }
-void removePrioQueueElem(PrioQueue **queue, int index)
-{    
-    double prio;
+
+void resetPrioQueue(PrioQueue **queue)
+{
     PrioQueue *tmp;
 
     tmp = *queue;
 
-    prio = tmp->prio[index];
+    // Only on overflow, the stamps are cleared to WHITE_STATE of generation 0
+    if(tmp->generation > UINT_MAX - 2 * STATE_GENERATION_STEP)
+    {
+        for(int i = 0; i < tmp->size; i++)
+            tmp->stamp[i * tmp->stamp_stride] = 0;
+        tmp->generation = 0;
+    }
+    else tmp->generation += STATE_GENERATION_STEP;
 
-    // Force the elem to be first in heap (for pop)
-    if(tmp->rem_policy == MINVAL_POLICY)
-        tmp->prio[index] = -INFINITY;
-    else
-        tmp->prio[index] = INFINITY;
+    tmp->last_elem_pos = -1;
+}
+
+inline void setPrioQueueState(PrioQueue *queue, int index, ElemState state)
+{
+    queue->stamp[index * queue->stamp_stride] = queue->generation + state;
+}
 
-    moveIndexUpPrioQueue(queue, index);
-    popPrioQueue(queue); // Discard
+static inline void siftUpPrioQueue(PrioQueue *queue, int pos, HeapElem elem)
+{
+    int father_pos;
+    HeapElem *heap;
+
+    heap = queue->heap;
+    father_pos = getFatherPos(queue, pos);
+
+    while(pos > 0 && heap[father_pos].key > elem.key)
+    {
+        heap[pos] = heap[father_pos];
+        queue->pos[heap[pos].index] = pos;
+
+        pos = father_pos;
+        father_pos = getFatherPos(queue, pos);
+    }
 
-    // Change back its original value
-    tmp->prio[index] = prio;
-    tmp->state[index] = WHITE_STATE; // Non-ordely removed
+    heap[pos] = elem;
+    queue->pos[elem.index] = pos;
 }
 
-void resetPrioQueue(PrioQueue **queue)
+static inline void siftDownPrioQueue(PrioQueue *queue, int pos, HeapElem elem)
 {
-    PrioQueue *tmp;
+    int son_pos, last_pos;
+    HeapElem *heap;
 
-    tmp = *queue;
+    heap = queue->heap;
+    last_pos = queue->last_elem_pos;
+    son_pos = getFirstSonPos(queue, pos);
 
-    for(int i = 0; i < tmp->size; i++)
+    while(son_pos <= last_pos)
     {
-        tmp->state[i] = WHITE_STATE;
-        tmp->pos[i] = -1;
-        tmp->node[i] = -1;
+        int best_pos, last_son_pos;
+
+        // The siblings are contiguous
+        last_son_pos = son_pos + queue->arity - 1;
+        if(last_son_pos > last_pos) last_son_pos = last_pos;
+
+        best_pos = son_pos;
+        for(int i = son_pos + 1; i <= last_son_pos; i++)
+            if(heap[i].key < heap[best_pos].key) best_pos = i;
+
+        if(heap[best_pos].key < elem.key)
+        {
+            heap[pos] = heap[best_pos];
+            queue->pos[heap[pos].index] = pos;
+
+            pos = best_pos;
+            son_pos = getFirstSonPos(queue, pos);
+        }
+        else son_pos = last_pos + 1; // In place
     }
-    tmp->last_elem_pos = -1;
-}
\ No newline at end of file
+
+    heap[pos] = elem;
+    queue->pos[elem.index] = pos;
+}
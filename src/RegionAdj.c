@@ -0,0 +1,267 @@
+#include "RegionAdj.h"
+
+//=============================================================================
+// Constants
+//=============================================================================
+#define INIT_PAIR_CAPACITY 64
+
+//=============================================================================
+// Private Prototypes
+//=============================================================================
+static uint64_t getRegionPairKey(int region_1, int region_2);
+static int getRegionPairSlot(RegionAdj *adj, uint64_t key);
+static void rehashRegionAdj(RegionAdj **adj, int capacity);
+static void reserveRegionAdjElems(RegionAdj **adj, int num_elems);
+
+//=============================================================================
+// Constructors & Deconstructors
+//=============================================================================
+RegionAdj *createRegionAdj(int num_regions)
+{
+    RegionAdj *adj;
+
+    adj = (RegionAdj*)calloc(1, sizeof(RegionAdj));
+
+    adj->num_regions = num_regions;
+    adj->num_pairs = 0;
+    adj->capacity = INIT_PAIR_CAPACITY;
+    adj->pairs = (uint64_t*)malloc(adj->capacity * sizeof(uint64_t));
+    adj->are_lists_built = false;
+    adj->adj_start = (int*)calloc(num_regions + 1, sizeof(int));
+    adj->adj_elems = NULL;
+    adj->elems_capacity = 0;
+
+    for(int i = 0; i < adj->capacity; i++)
+        adj->pairs[i] = EMPTY_REGION_PAIR;
+
+    return adj;
+}
+
+void freeRegionAdj(RegionAdj **adj)
+{
+    if(*adj != NULL)
+    {
+        RegionAdj *tmp;
+
+        tmp = *adj;
+
+        free(tmp->pairs);
+        free(tmp->adj_start);
+        free(tmp->adj_elems);
+        free(tmp);
+
+        *adj = NULL;
+    }
+}
+
+//=============================================================================
+// Bool
+//=============================================================================
+bool areRegionsAdj(RegionAdj *adj, int region_1, int region_2)
+{
+    uint64_t key;
+
+    key = getRegionPairKey(region_1, region_2);
+
+    return adj->pairs[getRegionPairSlot(adj, key)] == key;
+}
+
+bool insertRegionAdjPair(RegionAdj **adj, int region_1, int region_2)
+{
+    bool inserted;
+    int slot;
+    uint64_t key;
+    RegionAdj *tmp;
+
+    tmp = *adj;
+
+    key = getRegionPairKey(region_1, region_2);
+    slot = getRegionPairSlot(tmp, key);
+
+    if(tmp->pairs[slot] == key) inserted = false;
+    else
+    {
+        tmp->pairs[slot] = key;
+        tmp->num_pairs++;
+        tmp->are_lists_built = false;
+
+        // Load factor is kept at most 1/2
+        if(2 * tmp->num_pairs > tmp->capacity)
+            rehashRegionAdj(adj, 2 * tmp->capacity);
+
+        inserted = true;
+    }
+
+    return inserted;
+}
+
+//=============================================================================
+// Int
+//=============================================================================
+inline int getRegionAdjDegree(RegionAdj *adj, int region)
+{
+    return adj->adj_start[region + 1] - adj->adj_start[region];
+}
+
+static inline int getRegionPairSlot(RegionAdj *adj, uint64_t key)
+{
+    int slot, mask;
+    uint64_t hash;
+
+    // SplitMix64 finalizer
+    hash = key;
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+    hash = hash ^ (hash >> 31);
+
+    mask = adj->capacity - 1;
+    slot = (int)(hash & mask);
+
+    while(adj->pairs[slot] != EMPTY_REGION_PAIR && adj->pairs[slot] != key)
+        slot = (slot + 1) & mask;
+
+    return slot;
+}
+
+//=============================================================================
+// Uint64_t
+//=============================================================================
+static inline uint64_t getRegionPairKey(int region_1, int region_2)
+{
+    if(region_1 > region_2)
+        return ((uint64_t)region_2 << 32) | (uint32_t)region_1;
+    else
+        return ((uint64_t)region_1 << 32) | (uint32_t)region_2;
+}
+
+//=============================================================================
+// Void
+//=============================================================================
+void buildRegionAdjLists(RegionAdj **adj)
+{
+    RegionAdj *tmp;
+
+    tmp = *adj;
+
+    if(!tmp->are_lists_built)
+    {
+        reserveRegionAdjElems(adj, 2 * tmp->num_pairs);
+
+        // Degrees --> inclusive offsets (i.e., the end of each list)
+        for(int i = 0; i <= tmp->num_regions; i++)
+            tmp->adj_start[i] = 0;
+
+        for(int i = 0; i < tmp->capacity; i++)
+            if(tmp->pairs[i] != EMPTY_REGION_PAIR)
+            {
+                tmp->adj_start[(int)(tmp->pairs[i] >> 32)]++;
+                tmp->adj_start[(int)(tmp->pairs[i] & 0xFFFFFFFF)]++;
+            }
+
+        for(int i = 1; i < tmp->num_regions; i++)
+            tmp->adj_start[i] += tmp->adj_start[i - 1];
+        tmp->adj_start[tmp->num_regions] = 2 * tmp->num_pairs;
+
+        // Each list is filled backwards, thus its end becomes its beginning
+        for(int i = 0; i < tmp->capacity; i++)
+            if(tmp->pairs[i] != EMPTY_REGION_PAIR)
+            {
+                int region_1, region_2;
+
+                region_1 = (int)(tmp->pairs[i] >> 32);
+                region_2 = (int)(tmp->pairs[i] & 0xFFFFFFFF);
+
+                tmp->adj_elems[--tmp->adj_start[region_1]] = region_2;
+                tmp->adj_elems[--tmp->adj_start[region_2]] = region_1;
+            }
+
+        tmp->are_lists_built = true;
+    }
+}
+
+void keepRegionAdjPairs(RegionAdj **adj, bool *is_kept)
+{
+    int num_kept;
+    RegionAdj *tmp;
+
+    tmp = *adj;
+
+    // The list arena holds the kept pairs meanwhile
+    reserveRegionAdjElems(adj, 2 * tmp->num_pairs);
+    num_kept = 0;
+
+    for(int i = 0; i < tmp->capacity; i++)
+        if(tmp->pairs[i] != EMPTY_REGION_PAIR && 
+           is_kept[(int)(tmp->pairs[i] >> 32)] && is_kept[(int)(tmp->pairs[i] & 0xFFFFFFFF)])
+        {
+            tmp->adj_elems[2 * num_kept] = (int)(tmp->pairs[i] >> 32);
+            tmp->adj_elems[2 * num_kept + 1] = (int)(tmp->pairs[i] & 0xFFFFFFFF);
+            num_kept++;
+        }
+
+    resetRegionAdj(adj);
+
+    // No rehash occurs, since there are fewer pairs than before
+    for(int i = 0; i < num_kept; i++)
+        insertRegionAdjPair(adj, tmp->adj_elems[2 * i], tmp->adj_elems[2 * i + 1]);
+}
+
+void mergeRegionAdj(RegionAdj **adj, RegionAdj *other)
+{
+    for(int i = 0; i < other->capacity; i++)
+        if(other->pairs[i] != EMPTY_REGION_PAIR)
+            insertRegionAdjPair(adj, (int)(other->pairs[i] >> 32), (int)(other->pairs[i] & 0xFFFFFFFF));
+}
+
+static void rehashRegionAdj(RegionAdj **adj, int capacity)
+{
+    int old_capacity;
+    uint64_t *old_pairs;
+    RegionAdj *tmp;
+
+    tmp = *adj;
+
+    old_pairs = tmp->pairs;
+    old_capacity = tmp->capacity;
+
+    tmp->capacity = capacity;
+    tmp->pairs = (uint64_t*)malloc(capacity * sizeof(uint64_t));
+
+    for(int i = 0; i < capacity; i++)
+        tmp->pairs[i] = EMPTY_REGION_PAIR;
+
+    for(int i = 0; i < old_capacity; i++)
+        if(old_pairs[i] != EMPTY_REGION_PAIR)
+            tmp->pairs[getRegionPairSlot(tmp, old_pairs[i])] = old_pairs[i];
+
+    free(old_pairs);
+}
+
+static void reserveRegionAdjElems(RegionAdj **adj, int num_elems)
+{
+    RegionAdj *tmp;
+
+    tmp = *adj;
+
+    if(num_elems > tmp->elems_capacity)
+    {
+        free(tmp->adj_elems);
+
+        if(num_elems > 2 * tmp->elems_capacity) tmp->elems_capacity = num_elems;
+        else tmp->elems_capacity = 2 * tmp->elems_capacity;
+        tmp->adj_elems = (int*)malloc(tmp->elems_capacity * sizeof(int));
+    }
+}
+
+void resetRegionAdj(RegionAdj **adj)
+{
+    RegionAdj *tmp;
+
+    tmp = *adj;
+
+    for(int i = 0; i < tmp->capacity; i++)
+        tmp->pairs[i] = EMPTY_REGION_PAIR;
+
+    tmp->num_pairs = 0;
+    tmp->are_lists_built = false;
+}
@@ -1,5 +1,24 @@
 #include "Utils.h"
 
+//=============================================================================
+// Void*
+//=============================================================================
+void *callocAligned(size_t num_elems, size_t elem_size)
+{
+    size_t num_bytes;
+    void *mem = NULL;
+
+    num_bytes = num_elems * elem_size;
+    if(num_bytes == 0) num_bytes = MEM_ALIGNMENT;
+
+    if(posix_memalign(&mem, MEM_ALIGNMENT, num_bytes) != 0)
+        printError("callocAligned", "Could not allocate %zu bytes", num_bytes);
+
+    memset(mem, 0, num_bytes);
+
+    return mem;
+}
+
 //=============================================================================
 // Void
 //=============================================================================